@@ -11,21 +11,89 @@
 
 #include "settings.h"
 #include "system.h"
+#include "sdservice.h"
 
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <esp_wifi.h>
+#include <esp_netif.h>
+#include <lwip/dhcp.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <ff.h>
+#include <dirent.h>
+#include <memory>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebSrv.h>
 
 #include "md5.h"
 MD5 md5sum;
 
+#include "hoist.h"
+HoistRecord hoist;
+
 
 #define DEBUG_TEMPFILE_ONLY 0
 
-#define WWW_UPLOAD_TIMEOUT 10.0
-double www_upload_timer = 0.0;
-bool is_receiving_file = false;
+#define WWW_STALL_INITIAL   5000      // ms without data before the first chunk arrives
+#define WWW_STALL_MIN       2000      // ms lower bound of the adaptive stall window
+#define WWW_STALL_MAX       15000     // ms upper bound of the adaptive stall window
+#define WWW_STALL_FACTOR    4.0       // window = factor * time to receive one tcp window
+#define WWW_STALL_BYTES     5744      // lwip tcp receive window (4 * mss)
+#define WWW_RATE_PERIOD     100000    // us between transfer rate samples
+#define WWW_RATE_ALPHA      0.25      // ewma weight of each transfer rate sample
+#define WWW_WATCHDOG_PERIOD 100000    // us between stall watchdog checks
+#define WWW_MIN_IMAGE_SIZE  (600*1024)
+#define WWW_HEAD_MAX        2048      // image bytes buffered to check the app header and [APPDATA] block
+#define WWW_HASH_SUFFIX     ".md5"    // hash sidecar of the installed image -- '<md5> <size>'
+#define WWW_WRITE_BUFFER    8192      // stdio buffer of the image file -- chunks are appended, the card sees full buffers
+#define WWW_PROBE           1         // 1: time each upload chunk callback and count the ones that left the free heap changed
+#define WWW_PROBE_ALLOC     0         // 1: also count allocations inside the chunk callbacks -- needs CONFIG_HEAP_TRACING_STANDALONE
+#define WWW_PROBE_RECORDS   32        // heap trace records of one chunk callback
+
+#define APP_IMAGE_MAGIC     "P1APP"   // app image signature
+#define APP_IMAGE_HEADER    0x24      // header bytes up to the end of the [APPDATA] block size
+#define APP_META_OFFSET     0x1C      // u32 offset of the [APPDATA] block
+#define APP_META_SIZE       0x20      // u32 size of the [APPDATA] block
+
+#define UPLOAD_PROCEED      0         // UploadPrecheck(): receive the image
+#define UPLOAD_REJECT       1         // UploadPrecheck(): refuse the upload
+#define UPLOAD_INSTALLED    2         // UploadPrecheck(): the same image is installed -- launch it
+#define UPLOAD_RUNNING      3         // UploadPrecheck(): the same image is the running uploader -- nothing to do
+#define UPLOAD_LAUNCH_DELAY 100       // ms between the launch response and the restart, the loop task restarts
+
+#define LOOP_FPS            30        // frame rate after a button, network, or sd card event
+#define LOOP_IDLE_FPS       4         // frame rate while nothing happens
+#define LOOP_XFER_FPS       5         // frame rate during a transfer -- leaves the cpu to the tcp stack
+
+#if FF_MAX_SS == FF_MIN_SS
+#define UPLOAD_SECTOR_SIZE(fs) FF_MAX_SS
+#else
+#define UPLOAD_SECTOR_SIZE(fs) ((fs)->ssize)
+#endif
+
+#define RAW_DEFAULT_PORT    8082      // raw upload listener port -- 'UPLOADER'->'RawPort', 0 disables
+#define RAW_RX_TIMEOUT      20        // s before an idle raw connection is dropped
+#define RAW_FRAME_HEADER    'H'       // u32 appID, u32 appSize, char[32] appMD5, u32 flags
+#define RAW_FRAME_DATA      'D'       // image data
+#define RAW_FRAME_COMMIT    'C'       // end of image -- verify, install, and launch
+#define RAW_FRAME_REPLY     'R'       // server response text
+#define RAW_FRAME_SIZE      5         // u8 type + u32 payload length (little-endian)
+#define RAW_HEADER_SIZE     44
+#define RAW_FLAG_DRYRUN     0x01      // verify only -- nothing is installed or launched
+#define RAW_FLAG_NOWRITE    0x02      // don't write the image to the sd card (implies dry-run)
+#define RAW_FLAG_FORCE      0x04      // install even if the same image is installed already
+
+#define FILES_ROUTE         "/files"  // file server route prefix -- 'UPLOADER'->'FileServer', 0 disables
+#define FILES_BUFFER_SIZE   8192      // stdio buffer of the file being written by PUT
+#define FILES_LIST_LIMIT    100       // default directory listing page size
+#define FILES_LIST_ENTRY    320       // largest formatted directory listing entry
+
+#define TRACE_LIST_LINE     64        // largest formatted trace line
+volatile bool is_receiving_file = false;
+
+#define WIFI_CACHE_MAGIC 0x57494649
+#define WIFI_CACHE_TIMEOUT 5.0
 
 
 // logging and error message macros
@@ -39,10 +107,10 @@ bool is_receiving_file = false;
 
 // logging and error message macros
 #define REMOVE_TEMPFILE() \
-	if( www_image_file ) fclose( www_image_file ); \
-	if( www_image_file ) remove( www_path_temp ); \
-	is_receiving_file = false;\
-	www_upload_timer=0;
+	if( www_image_file ) sdClose( www_image_file ); \
+	if( www_path_temp[0] ) remove( www_path_temp ); \
+	www_image_file = NULL; \
+	is_receiving_file = false;
 
 #define WWW_ERROR(...) \
 	printf( "\n[%s] ", timestamp ); \
@@ -104,17 +172,1601 @@ void DEBUG_HTTP_REQUEST( AsyncWebServerRequest *request ) {
 
 
 
+// void HoistBoot() :: track the self-update state of the uploader image on startup
+void HoistBoot() {
+	if( !pocuter->SDCard->cardIsMounted() || !hoistRead( &hoist ) ) return;
+
+	switch( hoist.state ) {
+		// staged: started without the boot proxy -- the staged image is loaded and verified by the proxy
+		case HOIST_STATE_STAGED:
+			if( ++hoist.attempts > HOIST_MAX_ATTEMPTS ) {
+				printf("HOIST: Boot proxy didn't launch the staged image %u times, giving up...\n", HOIST_MAX_ATTEMPTS );
+				hoist.state = HOIST_STATE_NONE;
+				hoistWrite( &hoist );
+				return;
+			}
+			printf("HOIST: Staged image wasn't verified, switching to 'Self-Hoisting Boot Proxy' - #%u\n", HOIST_PROXY_ID );
+			hoistWrite( &hoist );
+			pocuter->OTA->setNextAppID( HOIST_PROXY_ID );
+			pocuter->OTA->restart();
+			return;
+
+		// launched: staged image hasn't reached the ready state yet -- unless the image was replaced since
+		case HOIST_STATE_LAUNCHED:
+			if( !hoistInstalled( &hoist ) ) {
+				printf("HOIST: Installed image isn't the staged image %s, dropping the record\n", hoist.md5 );
+				hoist.state = HOIST_STATE_NONE;
+				hoistWrite( &hoist );
+				return;
+			}
+			break;
+
+		default:
+			return;
+	}
+
+	// rollback: staged image failed to come up too many times -- restore backup via boot proxy
+	if( ++hoist.attempts > HOIST_MAX_ATTEMPTS ) {
+		printf("HOIST: Staged image failed to start %u times, rolling back...\n", HOIST_MAX_ATTEMPTS );
+		hoist.state = HOIST_STATE_ROLLBACK;
+		hoistWrite( &hoist );
+		pocuter->OTA->setNextAppID( HOIST_PROXY_ID );
+		pocuter->OTA->restart();
+	}
+
+	hoistWrite( &hoist );
+}
+
+// void HoistReady() :: confirm the staged uploader image once it completed its first frame
+// - not tied to the network: a working image started without an access point isn't rolled back
+void HoistReady() {
+	if( hoist.state != HOIST_STATE_LAUNCHED ) return;
+	printf("HOIST: Confirmed uploader image %s\n", hoist.md5 );
+	hoist.state = HOIST_STATE_CONFIRMED;
+	hoist.attempts = 0;
+	hoistWrite( &hoist );
+}
+
+
+
+// wifi connection cache -- retained in rtc memory across restarts (lost on power cycle)
+struct WifiCache {
+	uint32_t magic;
+	uint8_t  bssid[6];
+	uint8_t  channel;
+	uint32_t ip;
+	uint32_t netmask;
+	uint32_t gateway;
+	uint32_t dns;
+	uint32_t lease;      // s the dhcp lease is valid for
+	time_t   saved;      // time() the lease was stored -- the system time survives a restart
+};
+RTC_NOINIT_ATTR WifiCache wifi_cache;
+bool   wifi_fast_reconnect = false;
+bool   wifi_cache_applied = false;
+bool   wifi_cache_saved = false;
+double wifi_cache_timer = 0.0;
+
+// uint32_t FastReconnectLease( netif ) :: lease time of the bound dhcp address, 0 without one
+uint32_t FastReconnectLease( esp_netif_t *netif ) {
+	struct netif *lwip_netif = (struct netif*)esp_netif_get_netif_impl( netif );
+	if( !lwip_netif || !dhcp_supplied_address( lwip_netif ) ) return 0;
+	return netif_dhcp_data( lwip_netif )->offered_t0_lease;
+}
+
+// uint32_t FastReconnectRemaining() :: s left of the cached dhcp lease, 0 once it has expired
+uint32_t FastReconnectRemaining() {
+	time_t now = time( NULL );
+	if( now < wifi_cache.saved || now - wifi_cache.saved >= wifi_cache.lease ) return 0;
+	return wifi_cache.lease - (now - wifi_cache.saved);
+}
+
+// void FastReconnectFallback() :: drop the cached connection -- scan for the access point and start dhcp
+void FastReconnectFallback() {
+	wifi_cache.magic = 0;
+	wifi_cache_applied = false;
+	wifi_cache_saved = false;
+
+	wifi_config_t config;
+	if( esp_wifi_get_config( WIFI_IF_STA, &config ) == ESP_OK ) {
+		config.sta.bssid_set = false;
+		config.sta.channel = 0;
+		esp_wifi_set_config( WIFI_IF_STA, &config );
+	}
+
+	esp_netif_t *netif = esp_netif_get_handle_from_ifkey( "WIFI_STA_DEF" );
+	if( netif ) esp_netif_dhcpc_start( netif );
+}
+
+// void FastReconnectApply() :: pin cached access point + channel and re-use cached dhcp lease
+void FastReconnectApply() {
+	if( !wifi_fast_reconnect || wifi_cache.magic != WIFI_CACHE_MAGIC ) return;
+
+	// expired: the address may belong to another client by now
+	if( !FastReconnectRemaining() ) {
+		printf("* Fast reconnect: cached dhcp lease has expired, using dhcp\n");
+		wifi_cache.magic = 0;
+		return;
+	}
+
+	// apply: cached bssid + channel, skips the scan if the connection hasn't started yet
+	wifi_config_t config;
+	if( esp_wifi_get_config( WIFI_IF_STA, &config ) == ESP_OK ) {
+		memcpy( config.sta.bssid, wifi_cache.bssid, 6 );
+		config.sta.bssid_set = true;
+		config.sta.channel = wifi_cache.channel;
+		esp_wifi_set_config( WIFI_IF_STA, &config );
+	}
+
+	// apply: cached dhcp lease as static address
+	esp_netif_t *netif = esp_netif_get_handle_from_ifkey( "WIFI_STA_DEF" );
+	if( netif ) {
+		esp_netif_ip_info_t ip_info;
+		ip_info.ip.addr = wifi_cache.ip;
+		ip_info.netmask.addr = wifi_cache.netmask;
+		ip_info.gw.addr = wifi_cache.gateway;
+		esp_netif_dhcpc_stop( netif );
+		esp_netif_set_ip_info( netif, &ip_info );
+
+		esp_netif_dns_info_t dns_info;
+		dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+		dns_info.ip.u_addr.ip4.addr = wifi_cache.dns;
+		esp_netif_set_dns_info( netif, ESP_NETIF_DNS_MAIN, &dns_info );
+	}
+
+	printf("* Fast reconnect: using cached access point (channel %u) and address %s, lease valid for %u s\n",
+		wifi_cache.channel, inet_ntoa( wifi_cache.ip ), FastReconnectRemaining() );
+	wifi_cache_applied = true;
+	wifi_cache_timer = 0.0;
+}
+
+// void FastReconnectSave() :: store access point + dhcp lease of the established connection
+// - called every frame with an address, a cached address is saved again once dhcp has renewed it
+void FastReconnectSave() {
+	if( !wifi_fast_reconnect || wifi_cache_saved || wifi_cache_applied ) return;
+
+	wifi_ap_record_t ap_info;
+	esp_netif_t *netif = esp_netif_get_handle_from_ifkey( "WIFI_STA_DEF" );
+	esp_netif_ip_info_t ip_info;
+	esp_netif_dns_info_t dns_info;
+	uint32_t lease = netif ? FastReconnectLease( netif ) : 0;
+	if( !lease
+	|| esp_wifi_sta_get_ap_info( &ap_info ) != ESP_OK 
+	|| esp_netif_get_ip_info( netif, &ip_info ) != ESP_OK 
+	|| esp_netif_get_dns_info( netif, ESP_NETIF_DNS_MAIN, &dns_info ) != ESP_OK ) {
+		return;
+	}
+	wifi_cache_saved = true;
+
+	memcpy( wifi_cache.bssid, ap_info.bssid, 6 );
+	wifi_cache.channel = ap_info.primary;
+	wifi_cache.ip = ip_info.ip.addr;
+	wifi_cache.netmask = ip_info.netmask.addr;
+	wifi_cache.gateway = ip_info.gw.addr;
+	wifi_cache.dns = dns_info.ip.u_addr.ip4.addr;
+	wifi_cache.lease = lease;
+	wifi_cache.saved = time( NULL );
+	wifi_cache.magic = WIFI_CACHE_MAGIC;
+}
+
+// void FastReconnectCheck() :: fall back to scan + dhcp if the cached connection doesn't come up, or its lease expires
+void FastReconnectCheck() {
+	if( !wifi_cache_applied ) return;
+
+	// connected: the fallback timer only runs while the cached connection is down
+	if( pocuter->WIFI->getState() == PocuterWIFI::WIFI_STATE_CONNECTED && pocuter->WIFI->getIpInfo()->ipV4 ) {
+		wifi_cache_timer = 0.0;
+
+		// expired: nothing renews a static address -- hand it back to dhcp between uploads
+		if( FastReconnectRemaining() || is_receiving_file ) return;
+		printf("* Fast reconnect: cached dhcp lease has expired, renewing it...\n");
+		FastReconnectFallback();
+		return;
+	}
+
+	wifi_cache_timer += dt;
+	if( wifi_cache_timer < WIFI_CACHE_TIMEOUT ) return;
+
+	printf("* Fast reconnect: timed out, falling back to dhcp...\n");
+	FastReconnectFallback();
+}
+
 // global variables for response state tracking
 char  www_error_msg   [256] = "";
 char  www_path_image  [256] = "";
 char  www_path_backup [256] = "";
 char  www_path_temp   [256] = "";
+char  www_path_hash   [256] = "";
 
 char  www_image_hash  [33]  = "";
 FILE* www_image_file = 0;
 long  www_image_size = 0;
 
 long  www_app_size = 0;
+long  www_app_id = 0;
+
+uint8_t www_image_head[WWW_HEAD_MAX];   // start of the image -- checked before the rest is written
+char    www_write_buffer[WWW_WRITE_BUFFER];
+size_t  www_head_len = 0;
+bool    www_head_checked = false;
+
+bool    www_preallocate = true;   // 'UPLOADER'->'Preallocate' -- reserve the image file before writing
+bool    www_preallocated = false; // current image file was reserved up front
+int64_t www_write_time = 0;       // us spent in fwrite for the current image
+int64_t www_write_max = 0;        // us of the slowest single fwrite
+
+uint32_t www_chunk_count = 0;     // upload chunk callbacks of the current session
+uint32_t www_chunk_heap = 0;      // chunk callbacks after the first that left the free heap changed
+int64_t  www_chunk_time = 0;      // us spent in upload chunk callbacks
+uint32_t www_chunk_allocs = 0;    // allocations by any task while a chunk callback after the first ran
+bool     www_chunk_traced = false; // heap tracer available -- www_chunk_allocs is valid
+#if WWW_PROBE_ALLOC
+#include <esp_heap_trace.h>
+heap_trace_record_t www_trace_records[WWW_PROBE_RECORDS];
+#endif
+
+bool    loop_scheduler = true;    // 'UPLOADER'->'Scheduler' -- sleep between frames, 0 runs loop() flat out
+SchedulerStats www_loop_stats;    // scheduler stats at the start of the current upload
+
+
+// upload session stall detector state -- shared by the upload handler and the watchdog timer
+SemaphoreHandle_t www_upload_lock = NULL;
+esp_timer_handle_t www_watchdog = NULL;
+void *www_upload_owner = NULL;       // request or raw client owning the upload session
+volatile bool www_upload_stalled = false;   // set by the watchdog, the loop task drops the session and times out its client
+volatile long www_launch_app = 0;           // set by UploadLaunch(), the loop task restarts into it
+int64_t  www_launch_time = 0;     // us timestamp of the launch response
+
+int64_t  www_start_time = 0;      // us timestamp of the first upload chunk
+int64_t  www_data_time = 0;       // us timestamp of the last upload chunk
+int64_t  www_rate_time = 0;       // us timestamp of the current rate sample period
+long     www_rate_bytes = 0;      // bytes received in the current rate sample period
+double   www_rate = 0.0;          // ewma transfer rate in bytes/s
+uint32_t www_stall_window = WWW_STALL_INITIAL;
+
+// struct UploadLock :: scoped lock on the upload session state
+// - recursive: closing a connection runs its disconnect handler in the calling task
+struct UploadLock {
+	UploadLock()  { xSemaphoreTakeRecursive( www_upload_lock, portMAX_DELAY ); }
+	~UploadLock() { xSemaphoreGiveRecursive( www_upload_lock ); }
+};
+
+// struct UploadProbe :: scoped cpu time and heap change of one upload chunk callback -- declare after the UploadLock
+// - the free heap is shared with the network stack, a change can be an allocation of another task
+// - only memory still held when the callback returns is seen, a malloc and free inside the callback isn't --
+//   WWW_PROBE_ALLOC counts those with the heap tracer, which records the allocations of every task
+// - the first chunk of a session opens the session and isn't counted
+struct UploadProbe {
+#if WWW_PROBE
+	int64_t start;
+	size_t heap;
+	UploadProbe() : start( esp_timer_get_time() ), heap( heap_caps_get_free_size( MALLOC_CAP_8BIT ) ) {
+#if WWW_PROBE_ALLOC
+		static bool initialized = false;
+		if( !initialized ) www_chunk_traced = heap_trace_init_standalone( www_trace_records, WWW_PROBE_RECORDS ) == ESP_OK;
+		initialized = true;
+		if( www_chunk_traced ) heap_trace_start( HEAP_TRACE_ALL );
+#endif
+	}
+	~UploadProbe() {
+#if WWW_PROBE_ALLOC
+		if( www_chunk_traced ) {
+			heap_trace_stop();
+			if( www_chunk_count ) www_chunk_allocs += heap_trace_get_count();
+		}
+#endif
+		www_chunk_time += esp_timer_get_time() - start;
+		if( www_chunk_count++ && heap_caps_get_free_size( MALLOC_CAP_8BIT ) != heap ) www_chunk_heap++;
+	}
+#endif
+};
+
+// void UploadSessionStart( owner ) :: reset response state and stall detector for a new upload session
+void UploadSessionStart( void *owner ) {
+	www_error_msg[0]   = '\0';
+	www_path_temp[0]   = '\0';
+	www_path_image[0]  = '\0';
+	www_path_backup[0] = '\0';
+	www_path_hash[0]   = '\0';
+	www_image_hash[0]  = '\0';
+	www_image_file = NULL;
+	www_image_size = 0;
+	www_app_size = 0;
+	www_app_id = 0;
+	www_head_len = 0;
+	www_head_checked = false;
+	www_preallocated = false;
+	www_write_time = 0;
+	www_write_max = 0;
+	www_chunk_count = 0;
+	www_chunk_heap = 0;
+	www_chunk_time = 0;
+	www_chunk_allocs = 0;
+	md5sum.reset();
+
+	www_upload_owner = owner;
+	www_upload_stalled = false;
+	www_start_time = esp_timer_get_time();
+	www_data_time  = www_start_time;
+	www_rate_time  = www_start_time;
+	www_rate_bytes = 0;
+	www_rate = 0.0;
+	www_stall_window = WWW_STALL_INITIAL;
+}
+
+// void UploadDataReceived( size ) :: update transfer rate and adaptive stall window
+void UploadDataReceived( size_t size ) {
+	int64_t now = esp_timer_get_time();
+	www_data_time = now;
+
+	// rate: ewma over fixed sample periods -- single callbacks arrive in bursts
+	www_rate_bytes += size;
+	if( now - www_rate_time < WWW_RATE_PERIOD ) return;
+	double sample = www_rate_bytes * 1000000.0 / (now - www_rate_time);
+	www_rate = www_rate > 0 ? www_rate + WWW_RATE_ALPHA * (sample - www_rate) : sample;
+	www_rate_time = now;
+	www_rate_bytes = 0;
+
+	// window: a few times the expected time to refill the tcp receive window
+	double window = WWW_STALL_FACTOR * WWW_STALL_BYTES * 1000.0 / www_rate;
+	if( window < WWW_STALL_MIN ) window = WWW_STALL_MIN;
+	if( window > WWW_STALL_MAX ) window = WWW_STALL_MAX;
+	www_stall_window = window;
+}
+
+// double UploadAverageRate() :: average transfer rate of the current session in bytes/s
+double UploadAverageRate() {
+	double elapsed = (www_data_time - www_start_time) / 1000000.0;
+	return elapsed > 0 ? www_image_size / elapsed : 0.0;
+}
+
+// double UploadWriteRate() :: sd card write rate of the current image in bytes/s
+double UploadWriteRate() {
+	return www_write_time > 0 ? www_image_size * 1000000.0 / www_write_time : 0.0;
+}
+
+// double UploadChunkCost() :: us spent in the chunk callbacks per KiB of the current image
+double UploadChunkCost() {
+	return www_image_size > 0 ? www_chunk_time * 1024.0 / www_image_size : 0.0;
+}
+
+// bool UploadIdle() :: no data for longer than the stall window -- caller holds the upload lock
+bool UploadIdle() {
+	return is_receiving_file && esp_timer_get_time() - www_data_time >= www_stall_window * 1000LL;
+}
+
+// void UploadWatchdog( arg ) :: esp_timer callback -- flag upload sessions that stopped sending data
+// - the timer task is shared with input sampling, it never waits for the lock or touches the sd card
+void UploadWatchdog( void *arg ) {
+	if( !is_receiving_file || www_upload_stalled ) return;
+
+	// lock: held by a chunk that is being written -- data is arriving, check again on the next tick
+	if( xSemaphoreTakeRecursive( www_upload_lock, 0 ) != pdTRUE ) return;
+	bool stalled = UploadIdle();
+	xSemaphoreGiveRecursive( www_upload_lock );
+
+	if( !stalled ) return;
+	www_upload_stalled = true;
+	schedulerWake( WAKE_NETWORK );
+}
+
+// void UploadDisconnect( owner ) :: client dropped the connection -- releases the session, drops a transfer in progress
+void UploadDisconnect( void *owner ) {
+	UploadLock lock;
+	if( owner != www_upload_owner ) return;
+	www_upload_owner = NULL;
+	if( !is_receiving_file ) return;
+
+	char *timestamp = GetCurrentTimeString();
+	snprintf( www_error_msg, 255, "Error: Client disconnected after %u bytes", www_image_size );
+	LOGMSG(" QUIT: %s", www_error_msg );
+	REMOVE_TEMPFILE();
+	www_error_msg[0] = '\0';
+}
+
+
+// raw upload listener -- single client at a time
+AsyncServer *raw_server = NULL;
+uint16_t raw_port = 0;
+
+// char* GetStatusJSON() :: format server status as json string -- NULL if it doesn't fit the buffer
+char status_json[1536];
+char* GetStatusJSON() {
+	int len = snprintf( status_json, sizeof(status_json),
+		"{\"server\":\"Code Uploader\",\"uptime\":%0.3f,\"receiving\":%s,\"fast_reconnect\":%s,\"raw_port\":%u,"
+		"\"upload\":{\"received\":%ld,\"size\":%ld,\"rate\":%0.1f,\"average\":%0.1f,\"stall_window\":%0.3f,"
+		"\"preallocated\":%s,\"write_rate\":%0.1f,\"write_max\":%0.6f,\"chunks\":%u,\"cpu_per_kib\":%0.1f,\"heap_chunks\":%u,\"chunk_allocs\":%ld},"
+		"\"boot\":{\"restart\":%0.6f,\"phases\":[",
+		micros() / 1000000.0, is_receiving_file ? "true" : "false", wifi_cache_applied ? "true" : "false", raw_port,
+		www_image_size, www_app_size, www_rate, UploadAverageRate(), www_stall_window / 1000.0,
+		www_preallocated ? "true" : "false", UploadWriteRate(), www_write_max / 1000000.0,
+		www_chunk_count, UploadChunkCost(), www_chunk_heap, www_chunk_traced ? (long)www_chunk_allocs : -1L,
+		getBootPhaseGap() / 1000000.0
+	);
+
+	// truncated: every write must fit, a cut off document isn't json
+	const char *name;
+	uint32_t us;
+	for( int i=0; i < bootPhaseCount() && len >= 0 && len < (int)sizeof(status_json); i++ ) {
+		getBootPhase( i, &name, &us );
+		int n = snprintf( status_json + len, sizeof(status_json) - len, "%s[\"%s\",%0.6f]", i ? "," : "", name, us / 1000000.0 );
+		len = n < 0 ? n : len + n;
+	}
+	if( len >= 0 && len < (int)sizeof(status_json) ) {
+		int n = snprintf( status_json + len, sizeof(status_json) - len, "]}}" );
+		len = n < 0 ? n : len + n;
+	}
+	if( len < 0 || len >= (int)sizeof(status_json) ) {
+		printf("STATUS: json needs %d bytes, buffer has %u\n", len, (unsigned)sizeof(status_json) );
+		return NULL;
+	}
+	return &status_json[0];
+}
+
+
+
+/***************************************************************************************************
+// Upload Pipeline -- shared by the HTTP multipart route and the raw upload listener
+****************************************************************************************************/
+
+// uint64_t UploadFreeSpace() :: free bytes on the sd card, UINT64_MAX when unknown
+uint64_t UploadFreeSpace() {
+	FATFS *fs;
+	DWORD free_clusters;
+	char drive[8];
+	if( !sdServiceFatDrive( drive ) || f_getfree( drive, &free_clusters, &fs ) != FR_OK ) return UINT64_MAX;
+	return (uint64_t)free_clusters * fs->csize * UPLOAD_SECTOR_SIZE(fs);
+}
+
+// bool UploadInstalled( appID, appMD5, appSize ) :: the same image is installed -- read from its hash sidecar
+// - the sidecar is written on install, an image replaced by other means is newer than its sidecar
+bool UploadInstalled( long appID, const char *appMD5, long appSize ) {
+	char path_image[256], path_hash[256];
+	snprintf( path_image, 255, "%s/apps/%ld/esp32c3.app", pocuter->SDCard->getMountPoint(), appID );
+	snprintf( path_hash,  255, "%s" WWW_HASH_SUFFIX, path_image );
+
+	struct stat image, hash;
+	if( stat( path_image, &image ) != 0 || stat( path_hash, &hash ) != 0 ) return false;
+	if( image.st_size != appSize || image.st_mtime > hash.st_mtime ) return false;
+
+	char line[64] = "";
+	FILE *file = fopen( path_hash, "r" );
+	if( !file ) return false;
+	fgets( line, sizeof(line), file );
+	fclose( file );
+	return strncasecmp( line, appMD5, 32 ) == 0 && line[32] == ' ' && atol( line + 33 ) == appSize;
+}
+
+// int UploadPrecheck( appID, appSize, appMD5, flags, message, maxLength ) :: checks made before any image data is received
+// - returns UPLOAD_PROCEED, UPLOAD_REJECT, UPLOAD_INSTALLED, or UPLOAD_RUNNING with the response text in message
+// - doesn't touch the upload session, the caller may not own it
+int UploadPrecheck( long appID, long appSize, const char *appMD5, uint32_t flags, char *message, size_t maxLength ) {
+
+	// verify: no other upload in progress
+	if( is_receiving_file ) {
+		snprintf( message, maxLength, "Error: Upload already in progress!" );
+		return UPLOAD_REJECT;
+	}
+
+	// verify: declared values -- appID range, image size, and hash format
+	if( appID < 2 ) {
+		snprintf( message, maxLength, "Error: appID isn't a number >= 2!" );
+		return UPLOAD_REJECT;
+	}
+	if( appSize < WWW_MIN_IMAGE_SIZE ) {
+		snprintf( message, maxLength, "Error: Invalid size for upload file (%ld) -- must be larger than 600KiB!", appSize );
+		return UPLOAD_REJECT;
+	}
+	if( strlen( appMD5 ) != 32 || strspn( appMD5, "0123456789abcdefABCDEF" ) != 32 ) {
+		snprintf( message, maxLength, "Error: appMD5 isn't a 32 digit hex hash!" );
+		return UPLOAD_REJECT;
+	}
+	if( flags & RAW_FLAG_NOWRITE ) return UPLOAD_PROCEED;
+
+	// verify: card is mounted and has room for the image
+	if( !sdServiceIsMounted() ) {
+		snprintf( message, maxLength, "Error: SD card is not mounted!" );
+		return UPLOAD_REJECT;
+	}
+	uint64_t free_bytes = UploadFreeSpace();
+	if( free_bytes < (uint64_t)appSize ) {
+		snprintf( message, maxLength, "Error: Not enough free space on SD card: %llu bytes free, %ld bytes required", free_bytes, appSize );
+		return UPLOAD_REJECT;
+	}
+
+	// test: same image installed -- a self-update of the running image has nothing to launch
+	if( flags & (RAW_FLAG_DRYRUN | RAW_FLAG_FORCE) ) return UPLOAD_PROCEED;
+	if( !UploadInstalled( appID, appMD5, appSize ) ) return UPLOAD_PROCEED;
+	if( appID == HOIST_UPLOADER_ID ) {
+		snprintf( message, maxLength, "OK: Image is already installed and running (0 of %ld bytes sent)", appSize );
+		return UPLOAD_RUNNING;
+	}
+	snprintf( message, maxLength, "OK: Image is already installed, launching application... (0 of %ld bytes sent)", appSize );
+	return UPLOAD_INSTALLED;
+}
+
+// void UploadPreallocate( size ) :: reserve the temporary image file up front
+// - the whole extent is allocated before the transfer so the FAT is updated once instead of per cluster
+// - falls back to appending when the file can't be reserved, the free space was checked by UploadPrecheck()
+void UploadPreallocate( long size ) {
+	char *timestamp = GetCurrentTimeString();
+	if( !www_preallocate || size <= 0 ) return;
+
+	// map: vfs path to fatfs path on the drive of the sd card mount point
+	char drive[8], ffpath[256];
+	if( !sdServiceFatDrive( drive ) ) {
+		LOGMSG( "ALLOC: No fatfs drive found for '%s' -- appending instead", pocuter->SDCard->getMountPoint() );
+		return;
+	}
+	snprintf( ffpath, 255, "%s%s", drive, www_path_temp + strlen( pocuter->SDCard->getMountPoint() ) );
+
+	FIL file;
+	if( f_open( &file, ffpath, FA_WRITE | FA_CREATE_ALWAYS ) != FR_OK ) {
+		LOGMSG( "ALLOC: Unable to open '%s' -- appending instead", ffpath );
+		return;
+	}
+
+	// alloc: contiguous extent, otherwise stretch the file to allocate its cluster chain in one pass
+	const char *mode = "contiguous";
+	FRESULT result = FR_DENIED;
+#if FF_USE_EXPAND
+	result = f_expand( &file, size, 1 );
+#endif
+	if( result != FR_OK ) {
+		mode = "chained";
+		result = f_lseek( &file, size );
+		if( result == FR_OK && f_tell( &file ) != (FSIZE_t)size ) result = FR_DENIED;
+	}
+	f_close( &file );
+
+	if( result != FR_OK ) {
+		f_unlink( ffpath );
+		LOGMSG( "ALLOC: Failed to reserve %ld bytes (%d) -- appending instead", size, result );
+		return;
+	}
+	LOGMSG( "ALLOC: %ld bytes %s", size, mode );
+	www_preallocated = true;
+}
+
+// void UploadOpen( appID, write ) :: create application folder and open temporary image file
+void UploadOpen( long appID, bool write ) {
+	char *timestamp = GetCurrentTimeString();
+	is_receiving_file = true;
+	www_app_id = appID;
+	www_loop_stats = *getSchedulerStats();
+	schedulerWake( WAKE_NETWORK );
+	if( !write ) {
+		LOGMSG( "WRITE: skipped -- not writing image to sd card", 0 );
+		return;
+	}
+
+	// verify: card is mounted -- it may have been swapped since the server started
+	if( !sdServiceIsMounted() ) {
+		WWW_ERROR( "Error: SD card is not mounted!", 0 );
+	}
+
+	// mkdir: app folder
+	char dirpath[256];
+	snprintf( dirpath, 255, "%s/apps/%u", pocuter->SDCard->getMountPoint(), appID );
+	LOGMSG( " PATH: %s", dirpath );
+	if( !access( dirpath, F_OK) == 0 ) {
+		if( !mkdir( dirpath, S_IRWXU ) == 0 ) {
+			WWW_ERROR( "Error: Creating application folder '%s': errno: %u", dirpath, errno );
+		}
+	}
+
+	// calc: temporary, backup, and image file names
+	snprintf( www_path_image,  255, "%s/esp32c3.app",        dirpath );			
+	snprintf( www_path_backup, 255, "%s/esp32c3.app.backup", dirpath );
+	snprintf( www_path_temp,   255, "%s/esp32c3.app.upload", dirpath );			
+	snprintf( www_path_hash,   255, "%s" WWW_HASH_SUFFIX, www_path_image );
+
+	// alloc: reserve image file -- then overwrite it in place
+	UploadPreallocate( www_app_size );
+	if( strlen(www_error_msg) ) return;
+
+	// open: image file handle
+	LOGMSG( "WRITE: %s", www_path_temp );
+	www_image_file = sdOpen( www_path_temp, www_preallocated ? "r+" : "w" );
+	if( !www_image_file ) {
+		WWW_ERROR( "Error: Opening image file for writting '%s': %u", www_path_temp, errno );
+	}
+	setvbuf( www_image_file, www_write_buffer, _IOFBF, WWW_WRITE_BUFFER );
+}
+
+// void UploadCheckHead( data, size ) :: check the app image header and the AppID of its [APPDATA] block
+// - runs on the first bytes of the image so a wrong image is refused before the rest is transferred
+void UploadCheckHead( const uint8_t *data, size_t size ) {
+	if( www_head_checked ) return;
+
+	// buffer: the head may be split over several chunks
+	size_t count = min( size, (size_t)(WWW_HEAD_MAX - www_head_len) );
+	memcpy( www_image_head + www_head_len, data, count );
+	www_head_len += count;
+	if( www_head_len < APP_IMAGE_HEADER ) return;
+	char *timestamp = GetCurrentTimeString();
+
+	// verify: app image signature
+	if( memcmp( www_image_head, APP_IMAGE_MAGIC, strlen(APP_IMAGE_MAGIC) ) != 0 ) {
+		WWW_ERROR( "Error: Uploaded file isn't a Pocuter app image -- missing %s header!", APP_IMAGE_MAGIC );
+	}
+
+	// locate: [APPDATA] block -- blocks that don't fit the buffer aren't checked
+	uint32_t meta_offset, meta_size;
+	memcpy( &meta_offset, www_image_head + APP_META_OFFSET, 4 );
+	memcpy( &meta_size,   www_image_head + APP_META_SIZE,   4 );
+	if( meta_offset < APP_IMAGE_HEADER || meta_offset > WWW_HEAD_MAX || meta_size > WWW_HEAD_MAX - meta_offset ) {
+		www_head_checked = true;
+		LOGMSG( " HEAD: [APPDATA] block at %u (%u bytes) not checked", meta_offset, meta_size );
+		return;
+	}
+	if( www_head_len < meta_offset + meta_size ) return;
+	www_head_checked = true;
+
+	// verify: AppID of the [APPDATA] block is the declared appID
+	const char *line = (const char*)www_image_head + meta_offset;
+	const char *end = line + meta_size;
+	if( meta_size < 9 || memcmp( line, "[APPDATA]", 9 ) != 0 ) {
+		WWW_ERROR( "Error: Uploaded image has no [APPDATA] block!", 0 );
+	}
+	while( line < end ) {
+		const char *next = (const char*)memchr( line, '\n', end - line );
+		if( !next ) next = end;
+		if( next - line > 6 && memcmp( line, "AppID=", 6 ) == 0 ) {
+			long id = 0;
+			for( const char *c = line + 6; c < next && *c >= '0' && *c <= '9'; c++ ) id = id * 10 + (*c - '0');
+			if( id != www_app_id ) {
+				WWW_ERROR( "Error: Uploaded image is app %ld, not the declared appID %ld!", id, www_app_id );
+			}
+			LOGMSG( " HEAD: AppID %ld", id );
+			return;
+		}
+		line = next + 1;
+	}
+	LOGMSG( " HEAD: no AppID in [APPDATA] block", 0 );
+}
+
+// void UploadWrite( data, size ) :: append block to image file and hash
+void UploadWrite( uint8_t *data, size_t size ) {
+	if( !is_receiving_file || size == 0 ) return;
+	TRACE_SCOPE("write");
+
+	// verify: image header, and no more data than declared -- refused before anything is written
+	UploadCheckHead( data, size );
+	if( !is_receiving_file ) return;
+	if( www_image_size + (long)size > www_app_size ) {
+		char *timestamp = GetCurrentTimeString();
+		WWW_ERROR( "Error: Uploaded file is larger than declared file size: %ld bytes", www_app_size );
+	}
+
+	// write: image data stream -- time each block to find worst-case sd card latency
+	if( www_image_file ) {
+		int64_t start = esp_timer_get_time();
+		TRACE_BEGIN("fwrite");
+		long bytes = fwrite( data, 1, size, www_image_file );
+		TRACE_END("fwrite");
+		int64_t elapsed = esp_timer_get_time() - start;
+		www_write_time += elapsed;
+		if( elapsed > www_write_max ) www_write_max = elapsed;
+		if( bytes != size ) {
+			char *timestamp = GetCurrentTimeString();
+			WWW_ERROR( "Error: Writting file '%s' - block size mismatch: %u -> %u", www_path_temp, size, bytes );
+		}
+	}
+	www_image_size += size;
+	TRACE_COUNTER("upload KiB", www_image_size / 1024);
+	md5sum.add( data, size );
+	UploadDataReceived( size );
+}
+
+// void UploadClose() :: close image file and finalize hash
+void UploadClose() {
+	char *timestamp = GetCurrentTimeString();
+	LOGMSG(" DONE: %u bytes", www_image_size );
+	if( www_image_file ) {
+		sdClose( www_image_file );
+		www_image_file = NULL;
+		LOGMSG("  SD: %0.1f KiB/s, slowest write %0.3f ms (%s)", UploadWriteRate() / 1024.0,
+			www_write_max / 1000.0, www_preallocated ? "preallocated" : "appended" );
+	}
+
+	// hash: hex digits of the raw digest -- no string is built
+	uint8_t digest[MD5::HashBytes];
+	md5sum.getHash( digest );
+	for( int i = 0; i < MD5::HashBytes; i++ ) snprintf( www_image_hash + i * 2, 3, "%02x", digest[i] );
+	LOGMSG(" HASH: %s", www_image_hash );
+
+	// cost: cpu time of the chunk callbacks -- without the sd card writes, and chunks that changed the free heap
+#if WWW_PROBE
+	if( www_image_size ) {
+		LOGMSG(" CPU: %u chunks, %0.1f us/KiB, %0.1f us/KiB without writes, %u chunks changed the heap", www_chunk_count,
+			UploadChunkCost(), (www_chunk_time - www_write_time) * 1024.0 / www_image_size, www_chunk_heap );
+		if( www_chunk_traced ) {
+			LOGMSG(" CPU: %u allocations during the chunks after the first", www_chunk_allocs );
+		}
+	}
+#endif
+
+	// loop: share of the upload the loop() task slept instead of drawing frames
+	const SchedulerStats *loop_stats = getSchedulerStats();
+	uint64_t sleep_us = loop_stats->sleepUs - www_loop_stats.sleepUs;
+	uint64_t busy_us = loop_stats->busyUs - www_loop_stats.busyUs;
+	if( loop_scheduler && sleep_us + busy_us ) {
+		LOGMSG(" LOOP: %0.1f%% idle, %u frames", 100.0 * sleep_us / (sleep_us + busy_us), loop_stats->frames - www_loop_stats.frames );
+	}
+
+	is_receiving_file = false;
+	schedulerWake( WAKE_NETWORK );
+	printf(" ----");
+}
+
+// void UploadInstall( appID, appMD5, appSize, dryRun ) :: verify received image and install it
+// - on return www_error_msg holds the response text if the application must not be launched
+// - appID is changed to the boot proxy when self-hoisting the uploader
+void UploadInstall( long &appID, const char *appMD5, long appSize, bool dryRun ) {
+	char *timestamp = GetCurrentTimeString();
+
+	// verify: uploaded file is same size as declared size
+	if( www_image_size != appSize ) {
+		WWW_ERROR("Error: Uploaded file size doesn't match declared file size: %u -> %u", www_image_size, appSize );
+	}
+
+	// verify: appImage has a valid size
+	if( www_image_size < WWW_MIN_IMAGE_SIZE ) {
+		WWW_ERROR("Error: Invalid size for upload file (%u) -- must be larger than 600KiB!", www_image_size );
+	}
+
+	// verify: MD5 hash of uploaded file matches declared MD5 hash
+	if( strcmp( www_image_hash, appMD5 ) != 0 ) {
+		WWW_ERROR("Error: Uploaded MD5 hash doesn't equal declared file hash: %s -> %s", www_image_hash, appMD5 );
+	}
+
+	// dry-run: verify only -- used to benchmark the upload protocols
+	if( dryRun ) {
+		if( www_path_temp[0] ) remove( www_path_temp );
+		snprintf( www_error_msg, 255, "OK: Dry-run complete, nothing installed (%ld bytes at %0.1f KiB/s)",
+			www_image_size, UploadAverageRate() / 1024.0 );
+		LOGMSG("%s", www_error_msg );
+		return;
+	}
+
+	// debug: upload debug mode -- skip writing file unless self-hoisting
+	if( DEBUG_TEMPFILE_ONLY && appID != HOIST_UPLOADER_ID ){
+		remove( www_path_temp );			
+		LOGMSG("DEBUG: skipping installation of uploaded image file...", 0 );
+		sprintf( www_error_msg, "DEBUG: skipping installation of temporary image..." );
+		return;
+	}
+
+	// remove: hash sidecar and existing application backup file
+	LOGMSG(" DEL: %s", www_path_backup );
+	remove( www_path_hash );
+	remove( www_path_backup );
+
+	// rename: existing application file
+	LOGMSG("MOVE: %s -> %s", www_path_image, www_path_backup );
+	rename( www_path_image, www_path_backup );
+
+	// rename: temporary file
+	LOGMSG("MOVE: %s -> %s", www_path_temp, www_path_image );
+	rename( www_path_temp, www_path_image );
+
+	// write: hash sidecar -- lets the next upload of the same image skip the transfer
+	if( FILE *file = fopen( www_path_hash, "w" ) ) {
+		fprintf( file, "%s %ld\n", www_image_hash, www_image_size );
+		fclose( file );
+	}
+
+	// test: are we self-hoisting the 'Code Uploader' application?
+	if( appID == HOIST_UPLOADER_ID ) {
+		HoistRecord record;
+		hoistRead( &record );
+		record.state = HOIST_STATE_STAGED;
+		record.size = www_image_size;
+		record.attempts = 0;
+		strncpy( record.md5, www_image_hash, 32 );
+		hoistWrite( &record );
+
+		// launch: setNextAppID() doesn't reload the running app -- the boot proxy verifies and launches the image
+		printf(" ----\n");
+		LOGMSG("HOIST: Changing target application to 'Self-Hoisting Boot Proxy' - #%u", HOIST_PROXY_ID );
+		appID = HOIST_PROXY_ID;
+	}
+}
+
+// char* UploadLaunchMessage() :: response text for a successfully installed image
+char* UploadLaunchMessage() {
+	static char message[96];
+	snprintf( message, sizeof(message), "OK: Launching application... (%ld bytes at %0.1f KiB/s)",
+		www_image_size, UploadAverageRate() / 1024.0 );
+	return &message[0];
+}
+
+// void UploadLaunch( appID ) :: restart into the installed application -- response must be sent first
+// - runs on the tcp task, the loop task restarts once the response had UPLOAD_LAUNCH_DELAY ms to go out
+void UploadLaunch( long appID ) {
+	www_launch_time = esp_timer_get_time();
+	www_launch_app = appID;
+	schedulerWake( WAKE_NETWORK );
+}
+
+// void UploadLaunchPending() :: loop task -- restart into the application requested by UploadLaunch()
+void UploadLaunchPending() {
+	long appID = www_launch_app;
+	if( !appID || esp_timer_get_time() - www_launch_time < UPLOAD_LAUNCH_DELAY * 1000 ) return;
+
+	char *timestamp = GetCurrentTimeString();
+	printf(" ----\n");
+	LOGMSG(" RUN: %u\n", appID );
+	bootPhase("restart");
+	pocuter->OTA->setNextAppID( appID );
+	pocuter->OTA->restart();
+}
+
+
+
+/***************************************************************************************************
+// HTTP Upload Route -- multipart POST /upload
+//
+// The image is declared by the form fields in front of the file part, or by the query string or the
+// X-App-* headers. A declaration outside of the body is checked by the route filter once the request
+// headers are parsed, before the server answers 'Expect: 100-continue'. The server writes that answer
+// after the filter, so a refusal is kept by the request and answered with the first chunk of the body.
+// Refused uploads are answered before the rest of their body, which is ignored.
+****************************************************************************************************/
+
+// upload refusal -- kept in the request's temp object, the server frees it with the request
+struct UploadRefusal {
+	int code;
+	long launch;          // installed image to launch once the answer is sent, 0: none
+	bool sent;
+	char text[256];
+};
+
+// const char* UploadParam( request, name, header ) :: upload parameter from the form fields, the query string, or a header
+const char* UploadParam( AsyncWebServerRequest *request, const char *name, const char *header ) {
+	if( request->hasParam( name, true ) ) return request->getParam( name, true )->value().c_str();
+	if( request->hasParam( name ) ) return request->getParam( name )->value().c_str();
+	if( request->hasHeader( header ) ) return request->getHeader( header )->value().c_str();
+	return NULL;
+}
+
+// uint32_t UploadFlags( request ) :: raw upload flags of the dryRun, noWrite, and force parameters
+uint32_t UploadFlags( AsyncWebServerRequest *request ) {
+	uint32_t flags = 0;
+	if( UploadParam( request, "dryRun", "X-Dry-Run" ) ) {
+		flags |= RAW_FLAG_DRYRUN;
+		if( UploadParam( request, "noWrite", "X-No-Write" ) ) flags |= RAW_FLAG_NOWRITE;
+	}
+	if( UploadParam( request, "force", "X-Force" ) ) flags |= RAW_FLAG_FORCE;
+	return flags;
+}
+
+// bool UploadRefuse( request, text, code, launch ) :: keep the answer of a refused upload, sent by UploadAnswer()
+// - the upload and POST handlers ignore the rest of a refused request, the first refusal is kept
+// - false without memory for the refusal, the request is then answered by the POST handler as before
+bool UploadRefuse( AsyncWebServerRequest *request, const char *text, int code = 200, long launch = 0 ) {
+	if( request->_tempObject ) return true;
+	UploadRefusal *refusal = (UploadRefusal*) malloc( sizeof(UploadRefusal) );
+	if( !refusal ) return false;
+	refusal->code = code;
+	refusal->launch = launch;
+	refusal->sent = false;
+	strncpy( refusal->text, text, sizeof(refusal->text) - 1 );
+	refusal->text[ sizeof(refusal->text) - 1 ] = '\0';
+	request->_tempObject = refusal;
+	return true;
+}
+
+// void UploadAnswer( request ) :: send the answer of a refused upload once, then launch its installed image
+void UploadAnswer( AsyncWebServerRequest *request ) {
+	UploadRefusal *refusal = (UploadRefusal*) request->_tempObject;
+	if( !refusal || refusal->sent ) return;
+	refusal->sent = true;
+	request->send( refusal->code, "text/plain", refusal->text );
+	if( refusal->launch ) UploadLaunch( refusal->launch );
+}
+
+// bool UploadReject( request, text, code ) :: answer an upload before its body is complete
+bool UploadReject( AsyncWebServerRequest *request, const char *text, int code = 200 ) {
+	if( !UploadRefuse( request, text, code ) ) return false;
+	UploadAnswer( request );
+	return true;
+}
+
+// bool UploadFilter( request ) :: route filter -- check an upload declared by the query string or headers
+// - always accepts the request, a refused upload is answered here and still handled by the route
+bool UploadFilter( AsyncWebServerRequest *request ) {
+	if( request->method() != HTTP_POST || request->url() != "/upload" ) return true;
+	const char *paramID = UploadParam( request, "appID", "X-App-ID" );
+	if( !paramID ) return true;
+
+	char *timestamp = GetCurrentTimeString();
+	const char *paramSize = UploadParam( request, "appSize", "X-App-Size" );
+	const char *paramMD5 = UploadParam( request, "appMD5", "X-App-MD5" );
+	long appID = atol( paramID );
+	long appSize = paramSize ? atol( paramSize ) : 0;
+
+	// verify: declared image against the card and the installed image
+	char message[256];
+	int result = UploadPrecheck( appID, appSize, paramMD5 ? paramMD5 : "", UploadFlags( request ), message, sizeof(message) );
+	if( result == UPLOAD_PROCEED ) return true;
+
+	// refuse: answered with the first chunk, after the server's '100 Continue' -- then the installed image is launched
+	printf("\n\n");
+	LOGMSG("  PRE: appID: %ld, appSize: %ld -- %s", appID, appSize, message );
+	UploadRefuse( request, message, 200, result == UPLOAD_INSTALLED ? appID : 0 );
+	return true;
+}
+
+// void UploadStart( request, filename ) :: first chunk of the image -- verify parameters and open the upload session
+// - parameters and the filename are parsed once here, later chunks only append to the image
+void UploadStart( AsyncWebServerRequest *request, const char *filename ) {
+	char *timestamp = GetCurrentTimeString();
+	char *numtest;
+
+	// get: image file basename (webkit sends basename while firefox sends full path)
+	const char *image_name = strrchr( filename, '/' );
+	image_name = image_name ? image_name + 1 : filename;
+
+	// reset: error message + file pointer + stall detector
+	UploadSessionStart( request );
+	request->onDisconnect( [request]() { UploadDisconnect( request ); } );
+
+
+	// verify: request has valid appID parameter
+	const char *paramID = UploadParam( request, "appID", "X-App-ID" );
+	if( !paramID ) {
+		WWW_ERROR("Error: Missing appID parameter!",0);
+	}
+
+	// verify: appID is numeric and >= 2
+	long appID = strtol( paramID, &numtest, 10);
+	if( *numtest || appID < 2 ) {
+		WWW_ERROR("Error: appID isn't a number >= 2!",0);
+	}
+
+
+	// verify: request has appSize parameter
+	const char *paramSize = UploadParam( request, "appSize", "X-App-Size" );
+	if( !paramSize ) {
+		WWW_ERROR("Error: Missing appSize parameter!",0);
+	}
+
+	// verify: appSize is numeric
+	long appSize = strtol( paramSize, &numtest, 10);
+	if( *numtest ) {
+		WWW_ERROR("Error: appSize isn't a number!",0);
+	}
+	www_app_size = appSize;
+
+
+	// verify: appImage filename
+	if( strcmp( image_name, "esp32c3.app" ) != 0 ) {
+		WWW_ERROR( "Error: Invalid name for upload image file!: '%s'", image_name );
+	}
+
+	// verify: declared image against the card -- the installed image is only skipped for declarations outside of the body
+	const char *paramMD5 = UploadParam( request, "appMD5", "X-App-MD5" );
+	uint32_t flags = UploadFlags( request );
+	if( UploadPrecheck( appID, appSize, paramMD5 ? paramMD5 : "", flags | RAW_FLAG_FORCE, www_error_msg, 255 ) != UPLOAD_PROCEED ) {
+		LOGMSG("%s", www_error_msg );
+		return;
+	}
+
+
+	// debug: begin writing file to sd card -- dry-runs may skip the sd card
+	LOGMSG( "IMAGE: %s", image_name );
+	UploadOpen( appID, !(flags & RAW_FLAG_NOWRITE) );
+}
+
+
+
+/***************************************************************************************************
+// Raw Upload Protocol -- length-prefixed frames on a plain TCP connection
+//
+// [type:u8][length:u32] frames, HEADER -> DATA... -> COMMIT, answered by a single REPLY frame.
+// Data frames are written to the image file straight from the receive buffer.
+****************************************************************************************************/
+struct RawSession {
+	AsyncClient *client;
+	uint8_t  frame[RAW_FRAME_SIZE];   // current frame type + length
+	uint8_t  frame_len;
+	uint32_t remain;                  // payload bytes left in the current frame
+	uint8_t  header[RAW_HEADER_SIZE];
+	uint32_t header_len;
+	long     appID;
+	long     appSize;
+	char     appMD5[33];
+	uint32_t flags;
+	bool     started;                 // header accepted -- owns the upload session
+	bool     done;                    // reply sent -- ignore anything else the client sends
+} raw_session;
+
+// void RawReply( client, text ) :: send response frame -- the client closes the connection
+void RawReply( AsyncClient *client, const char *text ) {
+	uint32_t len = strlen( text );
+	uint8_t frame[RAW_FRAME_SIZE] = { RAW_FRAME_REPLY };
+	memcpy( frame + 1, &len, 4 );
+	client->add( (const char*)frame, RAW_FRAME_SIZE );
+	client->add( text, len );
+	client->send();
+	if( client == raw_session.client ) raw_session.done = true;
+}
+
+// void RawRespond() :: reply with the pending response message and drop the upload session
+void RawRespond() {
+	RawReply( raw_session.client, www_error_msg );
+	REMOVE_TEMPFILE();
+	www_error_msg[0] = '\0';
+	www_upload_owner = NULL;
+}
+
+// void RawBegin() :: header frame complete -- verify and open the upload session
+void RawBegin() {
+	RawSession &raw = raw_session;
+	char *timestamp = GetCurrentTimeString();
+	uint32_t appID, appSize;
+	memcpy( &appID,     raw.header,      4 );
+	memcpy( &appSize,   raw.header + 4,  4 );
+	memcpy( raw.appMD5, raw.header + 8,  32 );
+	memcpy( &raw.flags, raw.header + 40, 4 );
+	raw.appMD5[32] = '\0';
+	raw.appID = appID;
+	raw.appSize = appSize;
+	if( raw.flags & RAW_FLAG_NOWRITE ) raw.flags |= RAW_FLAG_DRYRUN;
+
+	printf("\n\n");
+	LOGMSG("  RAW: appID: %u, appSize: %u, appMD5: %s, flags: %u", appID, appSize, raw.appMD5, raw.flags );
+
+	// verify: no other upload in progress -- an http session owns the state until its response is sent
+	if( is_receiving_file || www_upload_owner ) {
+		RawReply( raw.client, "Error: Upload already in progress!" );
+		return;
+	}
+
+	UploadSessionStart( raw.client );
+	raw.started = true;
+	www_app_size = appSize;
+
+	// verify: declared image against the card and the installed image -- before the first data frame
+	int result = UploadPrecheck( raw.appID, raw.appSize, raw.appMD5, raw.flags, www_error_msg, 255 );
+	if( result == UPLOAD_REJECT || result == UPLOAD_RUNNING ) return RawRespond();
+	if( result == UPLOAD_INSTALLED ) {
+		LOGMSG("%s", www_error_msg );
+		RawRespond();
+		UploadLaunch( appID );
+		return;
+	}
+
+	UploadOpen( raw.appID, !(raw.flags & RAW_FLAG_NOWRITE) );
+	if( strlen(www_error_msg) ) return RawRespond();
+}
+
+// void RawCommit() :: image complete -- verify, install, and launch
+void RawCommit() {
+	RawSession &raw = raw_session;
+	if( !raw.started ) {
+		RawReply( raw.client, "Error: Commit without header!" );
+		return;
+	}
+	if( strlen(www_error_msg) ) return RawRespond();
+
+	UploadClose();
+	long appID = raw.appID;
+	UploadInstall( appID, raw.appMD5, raw.appSize, raw.flags & RAW_FLAG_DRYRUN );
+	if( strlen(www_error_msg) ) return RawRespond();
+
+	RawReply( raw.client, UploadLaunchMessage() );
+	UploadLaunch( appID );
+}
+
+// void RawData( client, data, len ) :: parse frames from a receive buffer
+void RawData( AsyncClient *client, uint8_t *data, size_t len ) {
+	TRACE_SCOPE("raw chunk");
+	RawSession &raw = raw_session;
+	UploadLock lock;
+	UploadProbe probe;
+
+	// session: the client was dropped while this task waited for the lock
+	if( client != raw.client ) return;
+
+	while( len && !raw.done ) {
+
+		// frame: collect type + length
+		if( raw.frame_len < RAW_FRAME_SIZE ) {
+			size_t count = min( (size_t)(RAW_FRAME_SIZE - raw.frame_len), len );
+			memcpy( raw.frame + raw.frame_len, data, count );
+			raw.frame_len += count;
+			data += count;
+			len -= count;
+			if( raw.frame_len < RAW_FRAME_SIZE ) return;
+
+			memcpy( &raw.remain, raw.frame + 1, 4 );
+			switch( raw.frame[0] ) {
+				case RAW_FRAME_HEADER:
+					if( raw.started || raw.remain != RAW_HEADER_SIZE ) {
+						RawReply( raw.client, "Error: Invalid header frame!" );
+						return;
+					}
+					raw.header_len = 0;
+					break;
+
+				case RAW_FRAME_DATA:
+					if( !raw.started ) {
+						RawReply( raw.client, "Error: Data frame without header!" );
+						return;
+					}
+					break;
+
+				case RAW_FRAME_COMMIT:
+					return RawCommit();
+
+				default:
+					RawReply( raw.client, "Error: Unknown frame type!" );
+					return;
+			}
+		}
+
+		// payload: header is buffered, image data is written straight from the receive buffer
+		size_t count = min( (size_t)raw.remain, len );
+		if( raw.frame[0] == RAW_FRAME_HEADER ) {
+			memcpy( raw.header + raw.header_len, data, count );
+			raw.header_len += count;
+			if( raw.header_len == RAW_HEADER_SIZE ) RawBegin();
+		} else {
+			UploadWrite( data, count );
+			if( strlen(www_error_msg) ) return RawRespond();
+		}
+
+		data += count;
+		len -= count;
+		raw.remain -= count;
+		if( !raw.remain ) raw.frame_len = 0;
+	}
+}
+
+// void RawConnect( client ) :: accept raw upload connection
+void RawConnect( AsyncClient *client ) {
+	client->setNoDelay( true );
+	client->setRxTimeout( RAW_RX_TIMEOUT );
+
+	// disconnect: drop the upload session if this client owns it, server-accepted clients are ours to free
+	client->onDisconnect( [](void *arg, AsyncClient *client) {
+		UploadDisconnect( client );
+		{
+			UploadLock lock;
+			if( client == raw_session.client ) raw_session.client = NULL;
+		}
+		delete client;
+	}, NULL );
+
+	// busy: single raw client at a time -- close once the reply is acked instead of waiting for the rx timeout
+	if( raw_session.client ) {
+		client->onAck( [](void *arg, AsyncClient *client, size_t len, uint32_t time) {
+			client->close();
+		}, NULL );
+		RawReply( client, "Error: Upload already in progress!" );
+		return;
+	}
+
+	memset( &raw_session, 0, sizeof(raw_session) );
+	raw_session.client = client;
+	client->onData( [](void *arg, AsyncClient *client, void *data, size_t len) {
+		RawData( client, (uint8_t*)data, len );
+	}, NULL );
+}
+
+
+
+// void UploadStallAbort() :: loop task -- drop the upload session flagged by the watchdog and time out its connection
+// - the connection isn't closed here: closing runs the disconnect handlers in the calling task, which free the
+//   client or the request while the async tcp task may be waiting for the lock in one of its data callbacks
+void UploadStallAbort() {
+	if( !www_upload_stalled ) return;
+
+	UploadLock lock;
+	www_upload_stalled = false;
+	if( !UploadIdle() ) return;
+
+	char *timestamp = GetCurrentTimeString();
+	int64_t idle = esp_timer_get_time() - www_data_time;
+	snprintf( www_error_msg, 255, "Error: Upload stalled -- no data for %0.1fs after %u bytes (%0.1f KiB/s)",
+		idle / 1000000.0, www_image_size, www_rate / 1024.0 );
+	LOGMSG(" QUIT: %s", www_error_msg );
+	REMOVE_TEMPFILE();
+	www_error_msg[0] = '\0';
+
+	// timeout: the client stopped sending -- its next poll in the async tcp task closes the connection
+	// - the lock keeps its disconnect handler from freeing it before this, later chunks see they lost the session
+	void *owner = www_upload_owner;
+	www_upload_owner = NULL;
+	if( !owner ) return;
+	if( owner == raw_session.client ) raw_session.client->setRxTimeout( 1 );
+	else ((AsyncWebServerRequest*)owner)->client()->setRxTimeout( 1 );
+}
+
+
+
+/***************************************************************************************************
+// File Server -- GET/PUT/DELETE on paths under the sd card mount point
+//
+// Reads and directory listings are streamed by response fillers straight from the card, writes are
+// streamed from the request body through a fixed buffer -- the heap use doesn't grow with file size.
+****************************************************************************************************/
+
+// struct FilesStream :: open file of a GET response -- closed when the response is destroyed
+struct FilesStream {
+	FILE *file;
+	~FilesStream() { if( file ) fclose( file ); }
+};
+
+// struct FilesListing :: state of a streamed directory listing
+struct FilesListing {
+	DIR  *dir;
+	char path[256];
+	char url[256];
+	long offset;                     // entries skipped before the page
+	long limit;                      // entries on the page
+	long index;                      // entries read so far
+	int  phase;                      // 0: header, 1: entries, 2: footer, 3: done
+	bool more;
+	char pending[FILES_LIST_ENTRY];  // formatted text not yet copied into a response chunk
+	size_t pending_len;
+	size_t pending_pos;
+	~FilesListing() { if( dir ) closedir( dir ); }
+};
+
+// file server state -- a single PUT at a time writes through the static buffer, guarded by the upload lock
+bool  files_enabled = true;
+char  files_put_buffer[FILES_BUFFER_SIZE];
+FILE* files_put_file = NULL;
+void* files_put_owner = NULL;
+char  files_put_path[256] = "";
+char  files_put_temp[256] = "";
+char  files_put_error[96] = "";
+long  files_put_size = 0;
+
+// bool FilesPath( request, dest ) :: map request url to a path under the mount point
+bool FilesPath( AsyncWebServerRequest *request, char *dest ) {
+	const char *url = request->url().c_str() + strlen( FILES_ROUTE );
+
+	// reject: parent directory segments
+	for( const char *seg = url; seg && *seg; seg = strchr( seg + 1, '/' ) ) {
+		if( strncmp( seg, "/..", 3 ) == 0 && (seg[3] == '/' || seg[3] == '\0') ) return false;
+	}
+
+	// strip: trailing slash of directory urls
+	size_t len = snprintf( dest, 256, "%s%s", pocuter->SDCard->getMountPoint(), url );
+	if( len >= 256 ) return false;
+	while( len > 1 && dest[len-1] == '/' ) dest[--len] = '\0';
+	return true;
+}
+
+// size_t FilesListNext( listing ) :: format the next piece of a directory listing -- 0 when done
+size_t FilesListNext( FilesListing &ls ) {
+	switch( ls.phase ) {
+
+		// header: path and page offset
+		case 0:
+			ls.phase = 1;
+			return snprintf( ls.pending, FILES_LIST_ENTRY, "{\"path\":\"%s\",\"offset\":%ld,\"entries\":[", ls.url, ls.offset );
+
+		// entries: fat file names can't contain quotes or backslashes -- no escaping required
+		case 1:
+			while( struct dirent *entry = readdir( ls.dir ) ) {
+				if( strcmp( entry->d_name, "." ) == 0 || strcmp( entry->d_name, ".." ) == 0 ) continue;
+				long index = ls.index++;
+				if( index < ls.offset ) continue;
+				if( index >= ls.offset + ls.limit ) {
+					ls.more = true;
+					break;
+				}
+
+				char path[512];
+				struct stat st;
+				snprintf( path, sizeof(path), "%s/%s", ls.path, entry->d_name );
+				bool is_dir = entry->d_type == DT_DIR;
+				long size = !is_dir && stat( path, &st ) == 0 ? st.st_size : 0;
+				return snprintf( ls.pending, FILES_LIST_ENTRY, "%s{\"name\":\"%s\",\"type\":\"%s\",\"size\":%ld}",
+					index > ls.offset ? "," : "", entry->d_name, is_dir ? "dir" : "file", size );
+			}
+			ls.phase = 2;
+			// fall through
+
+		// footer: more entries after this page
+		case 2:
+			ls.phase = 3;
+			return snprintf( ls.pending, FILES_LIST_ENTRY, "],\"more\":%s}", ls.more ? "true" : "false" );
+	}
+	return 0;
+}
+
+// void FilesList( request, path ) :: stream paged directory listing as chunked json
+void FilesList( AsyncWebServerRequest *request, const char *path ) {
+	std::shared_ptr<FilesListing> ls( new FilesListing() );
+	ls->dir = opendir( path );
+	if( !ls->dir ) {
+		request->send( 404, "text/plain", "Error: Directory not found!" );
+		return;
+	}
+	strncpy( ls->path, path, 255 );
+	strncpy( ls->url, request->url().c_str(), 255 );
+	ls->offset = request->hasParam("offset") ? atol( request->getParam("offset")->value().c_str() ) : 0;
+	ls->limit = request->hasParam("limit") ? atol( request->getParam("limit")->value().c_str() ) : FILES_LIST_LIMIT;
+	if( ls->offset < 0 ) ls->offset = 0;
+	if( ls->limit <= 0 ) ls->limit = FILES_LIST_LIMIT;
+
+	// fill: copy formatted entries into the response chunk, carrying over what doesn't fit
+	request->send( request->beginChunkedResponse( "application/json", [ls](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+		size_t len = 0;
+		while( len < maxLen ) {
+			if( ls->pending_pos == ls->pending_len ) {
+				ls->pending_len = min( FilesListNext( *ls ), (size_t)FILES_LIST_ENTRY - 1 );
+				ls->pending_pos = 0;
+				if( !ls->pending_len ) break;
+			}
+			size_t count = min( ls->pending_len - ls->pending_pos, maxLen - len );
+			memcpy( buffer + len, ls->pending + ls->pending_pos, count );
+			ls->pending_pos += count;
+			len += count;
+		}
+		return len;
+	}));
+}
+
+// void FilesGet( request ) :: stream file with optional byte range, or list directory
+void FilesGet( AsyncWebServerRequest *request ) {
+	char path[256];
+	if( !FilesPath( request, path ) ) {
+		request->send( 400, "text/plain", "Error: Invalid path!" );
+		return;
+	}
+
+	// directory: the mount point itself can't be stat'ed
+	struct stat st;
+	bool is_root = strcmp( path, pocuter->SDCard->getMountPoint() ) == 0;
+	if( !is_root && stat( path, &st ) != 0 ) {
+		request->send( 404, "text/plain", "Error: File not found!" );
+		return;
+	}
+	if( is_root || S_ISDIR( st.st_mode ) ) {
+		FilesList( request, path );
+		return;
+	}
+
+	// range: bytes=start-end, bytes=start-, or bytes=-suffix
+	long size = st.st_size;
+	long start = 0;
+	long end = size - 1;
+	bool partial = false;
+	if( request->hasHeader("Range") ) {
+		const char *range = request->getHeader("Range")->value().c_str();
+		char *tail;
+		if( strncmp( range, "bytes=", 6 ) == 0 ) {
+			// parse: every number must have digits and nothing may follow the range, else it is malformed
+			range += 6;
+			if( *range == '-' ) {
+				// suffix: longer than the file selects the whole file (rfc 9110), zero length is unsatisfiable
+				long suffix = strtol( range + 1, &tail, 10 );
+				partial = isdigit( range[1] ) && *tail == '\0';
+				start = suffix > 0 ? size - min( suffix, size ) : size;
+			} else {
+				start = strtol( range, &tail, 10 );
+				partial = isdigit( *range ) && *tail == '-';
+				if( partial && tail[1] ) {
+					const char *last = tail + 1;
+					end = strtol( last, &tail, 10 );
+					partial = isdigit( *last ) && *tail == '\0';
+				}
+			}
+			if( end >= size ) end = size - 1;
+		}
+		if( !partial || start < 0 || start > end ) {
+			char content_range[32];
+			snprintf( content_range, sizeof(content_range), "bytes */%ld", size );
+			AsyncWebServerResponse *response = request->beginResponse( 416, "text/plain", "Error: Invalid range!" );
+			response->addHeader( "Content-Range", content_range );
+			request->send( response );
+			return;
+		}
+	}
+
+	std::shared_ptr<FilesStream> stream( new FilesStream() );
+	stream->file = fopen( path, "r" );
+	if( !stream->file || fseek( stream->file, start, SEEK_SET ) != 0 ) {
+		request->send( 500, "text/plain", "Error: Unable to open file!" );
+		return;
+	}
+	setvbuf( stream->file, NULL, _IONBF, 0 );
+
+	// fill: read straight into the response buffer
+	AsyncWebServerResponse *response = request->beginResponse( "application/octet-stream", end - start + 1,
+		[stream](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+			return fread( buffer, 1, maxLen, stream->file );
+		}
+	);
+	response->addHeader( "Accept-Ranges", "bytes" );
+	if( partial ) {
+		char content_range[64];
+		snprintf( content_range, sizeof(content_range), "bytes %ld-%ld/%ld", start, end, size );
+		response->setCode( 206 );
+		response->addHeader( "Content-Range", content_range );
+	}
+	request->send( response );
+}
+
+// void FilesPutAbort() :: drop the file being written
+void FilesPutAbort() {
+	if( files_put_file ) sdClose( files_put_file );
+	if( files_put_temp[0] ) remove( files_put_temp );
+	files_put_file = NULL;
+	files_put_owner = NULL;
+	files_put_temp[0] = '\0';
+}
+
+// void FilesPutBody( request, data, len, index, total ) :: write request body to temporary file
+void FilesPutBody( AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total ) {
+	char *timestamp = GetCurrentTimeString();
+	UploadLock lock;
+
+	// start: single writer, temporary file renamed when the body is complete
+	if( index == 0 ) {
+		if( files_put_owner ) {
+			if( request->_tempObject == NULL ) request->_tempObject = strdup( "Error: Another file is being written!" );
+			return;
+		}
+		files_put_owner = request;
+		files_put_error[0] = '\0';
+		files_put_size = 0;
+		request->onDisconnect( [request]() {
+			UploadLock lock;
+			if( files_put_owner == request ) FilesPutAbort();
+		});
+
+		if( !FilesPath( request, files_put_path ) || strlen( files_put_path ) > 250 ) {
+			snprintf( files_put_error, sizeof(files_put_error), "Error: Invalid path!" );
+			files_put_temp[0] = '\0';
+			return;
+		}
+		snprintf( files_put_temp, 255, "%s.part", files_put_path );
+		files_put_file = sdOpen( files_put_temp, "w" );
+		if( !files_put_file ) {
+			snprintf( files_put_error, sizeof(files_put_error), "Error: Unable to create file: errno %d", errno );
+			files_put_temp[0] = '\0';
+			return;
+		}
+		setvbuf( files_put_file, files_put_buffer, _IOFBF, FILES_BUFFER_SIZE );
+		LOGMSG(" PUT: %s (%u bytes)", files_put_path, total );
+	}
+
+	// write: body chunk
+	if( files_put_owner != request || !files_put_file ) return;
+	if( fwrite( data, 1, len, files_put_file ) != len ) {
+		snprintf( files_put_error, sizeof(files_put_error), "Error: Writing file failed after %ld bytes", files_put_size );
+		FilesPutAbort();
+		files_put_owner = request;
+		return;
+	}
+	files_put_size += len;
+}
+
+// void FilesPut( request ) :: body complete -- replace target file
+void FilesPut( AsyncWebServerRequest *request ) {
+	char *timestamp = GetCurrentTimeString();
+
+	// busy: body was ignored
+	if( request->_tempObject ) {
+		request->send( 409, "text/plain", (const char*)request->_tempObject );
+		return;
+	}
+
+	// empty: no body callback for zero length requests
+	UploadLock lock;
+	if( files_put_owner != request ) {
+		char path[256];
+		FILE *file = FilesPath( request, path ) ? fopen( path, "w" ) : NULL;
+		if( file ) fclose( file );
+		request->send( file ? 201 : 500, "text/plain", file ? "OK: Created" : "Error: Unable to create file!" );
+		return;
+	}
+
+	// error: write failed
+	if( files_put_error[0] ) {
+		LOGMSG(" PUT: %s", files_put_error );
+		FilesPutAbort();
+		request->send( 500, "text/plain", files_put_error );
+		return;
+	}
+
+	// rename: temporary file to target
+	sdClose( files_put_file );
+	files_put_file = NULL;
+	remove( files_put_path );
+	bool ok = rename( files_put_temp, files_put_path ) == 0;
+	FilesPutAbort();
+
+	LOGMSG(" PUT: %s -- %ld bytes %s", files_put_path, files_put_size, ok ? "written" : "rename failed" );
+	request->send( ok ? 201 : 500, "text/plain", ok ? "OK: Created" : "Error: Unable to rename file!" );
+}
+
+// void FilesDelete( request ) :: remove file or empty directory
+void FilesDelete( AsyncWebServerRequest *request ) {
+	char *timestamp = GetCurrentTimeString();
+	char path[256];
+	struct stat st;
+	if( !FilesPath( request, path ) || strcmp( path, pocuter->SDCard->getMountPoint() ) == 0 ) {
+		request->send( 400, "text/plain", "Error: Invalid path!" );
+		return;
+	}
+	if( stat( path, &st ) != 0 ) {
+		request->send( 404, "text/plain", "Error: File not found!" );
+		return;
+	}
+
+	bool ok = S_ISDIR( st.st_mode ) ? rmdir( path ) == 0 : remove( path ) == 0;
+	LOGMSG(" DEL: %s%s", path, ok ? "" : " -- failed" );
+	if( ok ) request->send( 204 );
+	else request->send( 409, "text/plain", "Error: Unable to delete -- directory not empty?" );
+}
+
+// bool FilesReady( request ) :: route filter -- file server enabled and card mounted
+bool FilesReady( AsyncWebServerRequest *request ) {
+	return files_enabled && sdServiceIsMounted();
+}
+
+
+
+/***************************************************************************************************
+// Trace -- GET /trace sends the events of the trace recorder (system.cpp) as text
+//
+// The event ring is copied once per request and recording continues while the copy is sent, the
+// pocuter-trace tool converts the text to chrome trace json.
+****************************************************************************************************/
+
+// struct TraceListing :: snapshot of the trace ring being sent
+struct TraceListing {
+	TraceEvent *events;
+	uint32_t count;
+	uint32_t cursor;                 // traceFormat() line
+	char pending[TRACE_LIST_LINE];   // formatted text not yet copied into a response chunk
+	size_t pending_len;
+	size_t pending_pos;
+	~TraceListing() { free( events ); }
+};
+
+// void TraceGet( request ) :: stream a snapshot of the trace ring as chunked text
+void TraceGet( AsyncWebServerRequest *request ) {
+	if( !TRACE ) {
+		request->send( 404, "text/plain", "Error: Trace recorder isn't compiled in, build with TRACE=1!" );
+		return;
+	}
+	std::shared_ptr<TraceListing> tl( new TraceListing() );
+	tl->events = (TraceEvent*)malloc( TRACE_EVENTS * sizeof(TraceEvent) );
+	if( !tl->events ) {
+		request->send( 503, "text/plain", "Error: Not enough memory for the trace!" );
+		return;
+	}
+	tl->count = traceSnapshot( tl->events );
+
+	// fill: copy formatted lines into the response chunk, carrying over what doesn't fit
+	request->send( request->beginChunkedResponse( "text/plain", [tl](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+		size_t len = 0;
+		while( len < maxLen ) {
+			if( tl->pending_pos == tl->pending_len ) {
+				tl->pending_len = min( traceFormat( tl->events, tl->count, &tl->cursor, tl->pending, TRACE_LIST_LINE ), (size_t)TRACE_LIST_LINE - 1 );
+				tl->pending_pos = 0;
+				if( !tl->pending_len ) break;
+			}
+			size_t count = min( tl->pending_len - tl->pending_pos, maxLen - len );
+			memcpy( buffer + len, tl->pending + tl->pending_pos, count );
+			tl->pending_pos += count;
+			len += count;
+		}
+		return len;
+	}));
+}
+
 
 
 /***************************************************************************************************
@@ -122,13 +1774,30 @@ long  www_app_size = 0;
 ****************************************************************************************************/
 long lastFrame;
 void setup() {
+	bootPhase("setup");
 	pocuter = new Pocuter();
 	pocuter->begin(PocuterDisplay::BUFFER_MODE_DOUBLE_BUFFER);
 	pocuter->Display->continuousScreenUpdate(false);
+	bootPhase("begin");
 	
 	pocuterSettings.brightness = getSetting("GENERAL", "Brightness", 5);
 	pocuter->Display->setBrightness(pocuterSettings.brightness);
 	pocuterSettings.systemColor = getSetting("GENERAL", "SystemColor", C_LIME);
+	wifi_fast_reconnect = getSetting("UPLOADER", "FastReconnect", 0) != 0;
+	www_preallocate = getSetting("UPLOADER", "Preallocate", 1) != 0;
+	loop_scheduler = getSetting("UPLOADER", "Scheduler", 1) != 0;
+	const SettingsStats *settings_stats = getSettingsStats();
+	printf("* Settings: %u reads (%u from sd card) in %u us\n", settings_stats->reads, settings_stats->fileReads, settings_stats->readUs);
+	bootPhase("settings");
+
+	// wifi: opt-in fast reconnect using cached access point and dhcp lease
+	FastReconnectApply();
+
+	// sdcard: card detection in the background, mounts a swapped card without a restart
+	sdServiceBegin(true);
+
+	// check: self-update state of the uploader image
+	HoistBoot();
 	
 	// enable or disable double click (disabling can achieve faster reaction to single clicks)
 	disableDoubleClick(BUTTON_A);
@@ -138,6 +1807,17 @@ void setup() {
 	// setup your app here
 	lastFrame = micros();
 
+	// loop: the uploader runs until the user leaves it -- inactivity sleep would stop the server
+	pocuter->Sleep->setInactivitySleep( 0, (PocuterSleep::SLEEPTIMER_INTERRUPTS) 0x03 );
+
+	// upload: session lock and stall watchdog -- runs from the timer task so a busy loop can't starve it
+	www_upload_lock = xSemaphoreCreateRecursiveMutex();
+	esp_timer_create_args_t watchdog_args = {};
+	watchdog_args.callback = &UploadWatchdog;
+	watchdog_args.name = "upload_watchdog";
+	esp_timer_create( &watchdog_args, &www_watchdog );
+	esp_timer_start_periodic( www_watchdog, WWW_WATCHDOG_PERIOD );
+
 	printf("\n\nStarting Code Uploader Application...\n");
 
 	// route: GET /
@@ -148,7 +1828,20 @@ void setup() {
 		request->send_P(200, "text/html", index_html );
 	});
 
-	// route: POST /upload [appID] [appImage]
+	// route: GET /status
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+	printf("* Creating route for GET /status...\n");	
+	server.on("/status", HTTP_GET, [](AsyncWebServerRequest *request) {
+		DEBUG_HTTP_REQUEST( request );
+		const char *json = GetStatusJSON();
+		if( !json ) {
+			request->send( 500, "text/plain", "Error: Status too large!" );
+			return;
+		}
+		request->send(200, "application/json", json );
+	});
+
+	// route: POST /upload [appID] [appSize] [appMD5] [appImage] -- declared by form fields, query, or headers
 	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 	printf("* Creating route for POST /upload...\n");
 	server.on("/upload", HTTP_POST, 
@@ -159,220 +1852,160 @@ void setup() {
 		DEBUG_HTTP_REQUEST( request );
 		char *timestamp = GetCurrentTimeString();
 
-		// error: upload handler generated an error message
-		if( strlen(www_error_msg) ) {
-			LOGMSG("%s", www_error_msg );
-			request->send(200, "text/plain", www_error_msg );
-			www_error_msg[0] = '\0';
-			return;
-		} 
-
-		// verify: request has all parameters and proper types (string,file)
-		if( !(
-			request->hasParam("appID",true) && 
-			request->hasParam("appMD5",true) && 
-			request->hasParam("appSize",true) && 
-			request->hasParam("appImage",true,true)) 
-		) {
-			WWW_ERROR("Error: Missing or incorrect request parameters!",0);
-			request->send(200, "text/plain", www_error_msg );
+		// answered: refused before or during the body -- a refusal without body chunks is answered here
+		if( request->_tempObject ) {
+			UploadAnswer( request );
 			return;
 		}
 
-		// get request parameters
-		AsyncWebParameter* paramID = request->getParam("appID",true);
-		AsyncWebParameter* paramMD5 = request->getParam("appMD5",true);
-		AsyncWebParameter* paramSize = request->getParam("appSize",true);
-		AsyncWebParameter* paramImage = request->getParam("appImage",true,true);
-		long appID = atol( paramID->value().c_str() );
-		const char *appMD5 = paramMD5->value().c_str();
-		long appSize = atol( paramSize->value().c_str() );
-		long image_size = paramImage->size();
-
-		// verify: uploaded file is same size as declared size
-		if( www_image_size != appSize ) {
-			WWW_ERROR("Error: Uploaded file size doesn't match declared file size: %u -> %u", www_image_size, appSize );
-			request->send(200, "text/plain", www_error_msg );
+		// busy: another request or a raw upload owns the session state
+		UploadLock lock;
+		if( www_upload_owner && www_upload_owner != request ) {
+			request->send(409, "text/plain", "Error: Upload already in progress!" );
 			return;
 		}
 
-		// verify: appImage has a valid size
-		if( www_image_size < 600*1024 ) {
-			WWW_ERROR("Error: Invalid size for upload file (%u) -- must be larger than 600KiB!", www_image_size );
-			request->send(200, "text/plain", www_error_msg );
+		// verify: request has all parameters and proper types (string,file) -- and received its image
+		const char *paramID = UploadParam( request, "appID", "X-App-ID" );
+		const char *paramMD5 = UploadParam( request, "appMD5", "X-App-MD5" );
+		const char *paramSize = UploadParam( request, "appSize", "X-App-Size" );
+		if( www_upload_owner != request || !( paramID && paramMD5 && paramSize && request->hasParam("appImage",true,true) ) ) {
+			LOGMSG("Error: Missing or incorrect request parameters!",0);
+			request->send(200, "text/plain", "Error: Missing or incorrect request parameters!" );
+			if( www_upload_owner == request ) { REMOVE_TEMPFILE(); }
+			www_upload_owner = NULL;
 			return;
 		}
+		www_upload_owner = NULL;
 
-		// verify: MD5 hash of uploaded file matches declared MD5 hash
-		if( strcmp( www_image_hash, appMD5 ) != 0 ) {
-			WWW_ERROR("Error: Uploaded MD5 hash doesn't equal declared file hash: %s -> %s", www_image_hash, appMD5 );
+		// error: upload handler generated an error message
+		if( strlen(www_error_msg) ) {
+			LOGMSG("%s", www_error_msg );
 			request->send(200, "text/plain", www_error_msg );
-			return;			
-		}
-
-		// debug: upload debug mode -- skip writing file unless self-hoisting
-		if( DEBUG_TEMPFILE_ONLY && appID != 8080 ){
-			remove( www_path_temp );			
-			LOGMSG("DEBUG: skipping installation of uploaded image file...", 0 );
-			request->send(200, "text/plain", "DEBUG: skipping installation of temporary image..." );
+			www_error_msg[0] = '\0';
 			return;
-		}
-
-		// remove: existing application backup file
-		LOGMSG(" DEL: %s", www_path_backup );
-		remove( www_path_backup );
-
-		// rename: existing application file
-		LOGMSG("MOVE: %s -> %s", www_path_image, www_path_backup );
-		rename( www_path_image, www_path_backup );
+		} 
 
-		// rename: temporary file
-		LOGMSG("MOVE: %s -> %s", www_path_temp, www_path_image );
-		rename( www_path_temp, www_path_image );
+		// get request parameters
+		long appID = atol( paramID );
+		const char *appMD5 = paramMD5;
+		long appSize = atol( paramSize );
+		bool dryRun = UploadFlags( request ) & RAW_FLAG_DRYRUN;
 
-		// test: are we self-hoisting the 'Code Uploader' application?
-		if( appID == 8080 ) {
-			printf(" ----\n");
-			LOGMSG("HOIST: Changing target application to 'Self-Hoisting Boot Proxy' - #8081", 0 );
-			appID = 8081;
+		// install: verify uploaded image and replace application
+		UploadInstall( appID, appMD5, appSize, dryRun );
+		if( strlen(www_error_msg) ) {
+			request->send(200, "text/plain", www_error_msg );
+			www_error_msg[0] = '\0';
+			return;
 		}
 
-		// send: request response
-		printf(" ----\n");
-		LOGMSG(" RUN: %u\n", appID );
-		request->send(200, "text/plain", "OK: Launching application...");
-		delay(100);
-
-		// launch: application
-		pocuter->OTA->setNextAppID( appID );
-		pocuter->OTA->restart();
+		// launch: send response then restart into application
+		request->send(200, "text/plain", UploadLaunchMessage() );
+		UploadLaunch( appID );
 	},
 
 	// UPLOAD: File upload request handler -- save streamed file...
 	//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-
-	[](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t size, bool final) {
-		char image_name[256];
-		char *timestamp = GetCurrentTimeString();
-		char *numtest;
+	[](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t size, bool final) {
+		TRACE_SCOPE("http chunk");
+		UploadLock lock;
+		UploadProbe probe;
+
+		// answered: refused before or during the body -- answer a refusal of the route filter, ignore the rest
+		if( request->_tempObject ) {
+			UploadAnswer( request );
+			return;
+		}
 
-		// get: image file basname (webkit sends basename while firefox sends full path)
-		memset( image_name, 0, 256 );
-		const char *raw_image_name = filename.c_str();
-		if( char *basname = strrchr( raw_image_name, '/' ) ) {
-			strncpy( image_name, basname + 1, 255 );
-		} else {
-			strncpy( image_name, raw_image_name, 255 );
+		// dropped: the session of this request was aborted while this task waited for the lock -- ignore the rest
+		if( index && www_upload_owner != request ) return;
+
+		// busy: another request or a raw upload owns the session state -- don't touch it
+		if( www_upload_owner && www_upload_owner != request ) {
+			char *timestamp = GetCurrentTimeString();
+			LOGMSG("Error: Upload already in progress!",0);
+			UploadReject( request, "Error: Upload already in progress!", 409 );
+			return;
 		}
 
 		// start: verify parameters, mkdir, fopen
 		if( index == 0 ) {
 			printf("\n\n");
 			DEBUG_HTTP_REQUEST( request );
-
-			// reset: error message + file pointer\			
-			www_error_msg[0]   = '\0';
-			www_path_temp[0]   = '\0';
-			www_path_image[0]  = '\0';
-			www_path_backup[0] = '\0';
-			www_image_hash[0]  = '\0';
-			www_image_file = NULL;			
-			www_image_size = 0;
-			www_app_size = 0;
-			www_upload_timer = 0.0;
-			md5sum.reset();
-
-
-			// verify: request has valid appID parameter
-			if( !(request->hasParam("appID",true) ) ) {
-				WWW_ERROR("Error: Missing appID parameter!",0);
-			}
-
-			// verify: appID is numeric and >= 2
-			AsyncWebParameter* paramID = request->getParam("appID",true);
-			long appID = strtol( paramID->value().c_str(), &numtest, 10);
-			if( *numtest || appID < 2 ) {
-				WWW_ERROR("Error: appID isn't a number >= 2!",0);
-			}
-
-
-			// verify: request has appSize parameter
-			if( !(request->hasParam("appSize",true) ) ) {
-				WWW_ERROR("Error: Missing appSize parameter!",0);
-			}
-
-			// verify: appSize is numeric
-			AsyncWebParameter* paramSize = request->getParam("appSize",true);
-			long appSize = strtol( paramSize->value().c_str(), &numtest, 10);
-			if( *numtest ) {
-				WWW_ERROR("Error: appSize isn't a number!",0);
-			}
-			www_app_size = appSize;
-
-
-			// verify: appImage filename
-			if( strcmp( image_name, "esp32c3.app" ) != 0 ) {
-				WWW_ERROR( "Error: Invalid name for upload image file!: '%s'", image_name );
-			}
-
-
-			// debug: begin writing file to sd card
-			LOGMSG( "IMAGE: %S", image_name );
-			is_receiving_file = true;
-
-			// mkdir: app folder
-			char dirpath[256];
-			snprintf( dirpath, 255, "%s/apps/%u", pocuter->SDCard->getMountPoint(), appID );
-			LOGMSG( " PATH: %s", dirpath );
-			if( !access( dirpath, F_OK) == 0 ) {
-				if( !mkdir( dirpath, S_IRWXU ) == 0 ) {
-					WWW_ERROR( "Error: Creating application folder '%s': errno: %u", dirpath, errno );
-				}
-			}
-
-			// calc: temporary, backup, and image file names
-			snprintf( www_path_image,  255, "%s/esp32c3.app",        dirpath );			
-			snprintf( www_path_backup, 255, "%s/esp32c3.app.backup", dirpath );
-			snprintf( www_path_temp,   255, "%s/esp32c3.app.upload", dirpath );			
-
-			// open: image file handle
-			LOGMSG( "WRITE: %s", www_path_temp );
-			www_image_file = fopen( www_path_temp, "w" );
-			if( !www_image_file ) {
-				WWW_ERROR( "Error: Opening image file for writting '%s': %u", www_path_temp, errno );
-			}
+			UploadStart( request, filename.c_str() );
 		}
 
-		// error: ignore data
-		if( strlen(www_error_msg) ) return;
-
 		// write: image data stream
-		if( size != 0 && www_image_file ) {
-			//LOGMSG( " DATA: %u bytes", size );
-			long bytes = fwrite( data, 1, size, www_image_file );
-			if( bytes != size ) {
-				WWW_ERROR( "Error: Writting file '%s' - block size mismatch: %u -> %u", www_path_temp, size, bytes );
-			}
-			www_image_size += size;
-			md5sum.add( data, size );
+		if( www_upload_owner != request ) return;
+		if( !www_error_msg[0] ) UploadWrite( data, size );
+
+		// error: answer now instead of after the whole image -- the client can stop sending
+		// - without memory for the answer the message and the session are kept for the POST handler
+		if( www_error_msg[0] ) {
+			bool answered = UploadReject( request, www_error_msg );
+			REMOVE_TEMPFILE();
+			if( !answered ) return;
+			www_error_msg[0] = '\0';
+			www_upload_owner = NULL;
+			return;
 		}
 
 		// stop: close open file
-		if( final && www_image_file ) {
-			LOGMSG(" DONE: %u bytes", www_image_size );
-			fclose( www_image_file ); 			
+		if( final && is_receiving_file ) {
+			UploadClose();
+		}
 
- 			strncpy( www_image_hash, md5sum.getHash().c_str(), 32 );
- 			LOGMSG(" HASH: %s", www_image_hash );
+	}).setFilter( UploadFilter );
 
-			is_receiving_file = false;			
- 			printf(" ----");
-		}
+	// route: GET/PUT/DELETE /files/[path]
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+	files_enabled = getSetting("UPLOADER", "FileServer", 1) != 0;
+	printf("* Creating routes for %s/...\n", FILES_ROUTE);
+	server.on(FILES_ROUTE, HTTP_GET, [](AsyncWebServerRequest *request) {
+		DEBUG_HTTP_REQUEST( request );
+		FilesGet( request );
+	}).setFilter( FilesReady );
+	server.on(FILES_ROUTE, HTTP_DELETE, [](AsyncWebServerRequest *request) {
+		DEBUG_HTTP_REQUEST( request );
+		FilesDelete( request );
+	}).setFilter( FilesReady );
+	server.on(FILES_ROUTE, HTTP_PUT, FilesPut, NULL, FilesPutBody).setFilter( FilesReady );
 
+	// route: GET /trace
+	// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+	printf("* Creating route for GET /trace...\n");
+	server.on("/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+		DEBUG_HTTP_REQUEST( request );
+		TraceGet( request );
 	});
 
+	bootPhase("routes");
+
+	// raw: length-prefixed upload listener advertised by GET /status
+	raw_port = getSetting("UPLOADER", "RawPort", RAW_DEFAULT_PORT);
+	if( raw_port ) {
+		printf("* Starting Raw Upload Listener on port %u...\n", raw_port);
+		raw_server = new AsyncServer( raw_port );
+		raw_server->setNoDelay( true );
+		raw_server->onClient( [](void *arg, AsyncClient *client) { RawConnect( client ); }, NULL );
+		raw_server->begin();
+	}
+
   	// Start server
 	printf("* Starting Web Server...\n\n");
   	server.begin();
+	bootPhase("server");
+}
+
+
+
+// void UpdateScreen() :: draw the profiler hud and send the frame to the display
+void UpdateScreen() {
+	profileDrawHud();
+	PROFILE("screen");
+	TRACE_SCOPE("screen");
+	pocuter->Display->updateScreen();
 }
 
 
@@ -382,24 +2015,57 @@ void setup() {
 ****************************************************************************************************/
 void loop() {
 	uint text_y = 0;
-	pocuter->Sleep->setInactivitySleep( 0, (PocuterSleep::SLEEPTIMER_INTERRUPTS) 0x03 );
 
+	// frame: sleep until the next frame is due or an event arrives
+	if( loop_scheduler ) {
+		schedulerRate( is_receiving_file ? LOOP_XFER_FPS : LOOP_FPS, is_receiving_file ? LOOP_XFER_FPS : LOOP_IDLE_FPS );
+		schedulerWait();
+	}
+
+	TRACE_SCOPE("loop");
 	dt = (micros() - lastFrame) / 1000.0 / 1000.0;
 	lastFrame = micros();
 	updateInput();
 	
+	// boot: print boot phases recorded since the last frame
+	bootPhaseDump();
+
+	// upload: drop a session the stall watchdog flagged, restart into a launched application
+	UploadStallAbort();
+	UploadLaunchPending();
+
+	// sdcard: card swapped while running -- close the files of the removed card before the service unmounts it
+	// - the upload lock keeps an upload or a PUT from writing to a file while it is closed
+	SDServiceEvent card_event;
+	while( sdServiceGetEvent( &card_event ) ) {
+		if( card_event.type != SDSERVICE_EVENT_REMOVED ) continue;
+
+		UploadLock lock;
+		char *timestamp = GetCurrentTimeString();
+		if( is_receiving_file && www_image_file ) {
+			snprintf( www_error_msg, 255, "Error: SD card removed after %ld bytes", www_image_size );
+			LOGMSG(" QUIT: %s", www_error_msg );
+			REMOVE_TEMPFILE();
+		}
+		if( files_put_file ) {
+			snprintf( files_put_error, sizeof(files_put_error), "Error: SD card removed after %ld bytes", files_put_size );
+			LOGMSG(" PUT: %s", files_put_error );
+			sdClose( files_put_file );
+			files_put_file = NULL;
+		}
+	}
+	
 	if (ACTION_BACK_TO_MENU) {
+		bootPhase("restart");
 		pocuter->OTA->setNextAppID(1);
 		pocuter->OTA->restart();
 	}
 
-	// check: upload timout counter
-	if( is_receiving_file ) www_upload_timer += dt;
-	if( www_upload_timer >= WWW_UPLOAD_TIMEOUT ) {
-		char *timestamp = GetCurrentTimeString();
-		LOGMSG(" QUIT: File transfer timed out!",0);
-		REMOVE_TEMPFILE();
-	}
+	// profiler: button A toggles the frame time hud
+	if( ACTION_SINGLE_CLICK_A ) profileHud( !profileHudVisible() );
+
+	// trace: button C prints the trace recorder events to the serial console
+	if( ACTION_SINGLE_CLICK_C ) traceDump();
 
 	// dt contains the amount of time that has passed since the last update, in seconds
 	UGUI* gui = pocuter->ugui;
@@ -407,21 +2073,32 @@ void loop() {
 	uint16_t sizeY;
 	pocuter->Display->getDisplaySize(sizeX, sizeY);
 	
-	gui->UG_FillScreen( C_BLACK );
-	gui->UG_FillFrame(0, 0, sizeX, 13, C_BLUE);
-	gui->UG_FontSelect(&FONT_POCUTER_5X7);
-	gui->UG_SetForecolor( C_YELLOW );
-    CENTER_TEXT( 0, "Code Uploader" );
-	gui->UG_SetForecolor( C_WHITE );
-
-	// sdcard: is not mounted
-	if( !pocuter->SDCard->cardIsMounted() ) {
+	{
+		PROFILE("draw");
+		TRACE_SCOPE("draw");
+		gui->UG_FillScreen( C_BLACK );
+		gui->UG_FillFrame(0, 0, sizeX, 13, C_BLUE);
+		gui->UG_FontSelect(&FONT_POCUTER_5X7);
 		gui->UG_SetForecolor( C_YELLOW );
-		NEXTLINE( "SD card is not" );
-		NEXTLINE( "mounted.");
-		text_y += 2;
-		NEXTLINE( "Please restart" );
-		NEXTLINE( "the application!" );
+		CENTER_TEXT( 0, "Code Uploader" );
+		gui->UG_SetForecolor( C_WHITE );
+	}
+
+	// sdcard: is not mounted -- the card service mounts it as soon as a card is inserted
+	SDServiceState card_state = sdServiceState();
+	if( card_state != SDSERVICE_MOUNTED ) {
+		gui->UG_SetForecolor( C_YELLOW );
+		if( card_state == SDSERVICE_MOUNTING ) {
+			NEXTLINE( "Mounting SD" );
+			NEXTLINE( "card...");
+		} else {
+			NEXTLINE( "SD card is not" );
+			NEXTLINE( "mounted.");
+			text_y += 2;
+			NEXTLINE( card_state == SDSERVICE_NO_CARD ? "Please insert" : "Please re-insert" );
+			NEXTLINE( "the SD card!" );
+		}
+		UpdateScreen();
 		return;
 	}
 
@@ -430,6 +2107,7 @@ void loop() {
 	pocuter->WIFI->getCredentials( &cred );	
 
 	// wifi: connection not established or unavailable
+	FastReconnectCheck();
 	if( pocuter->WIFI->getState() != PocuterWIFI::WIFI_STATE_CONNECTED ) {
 		if( cred.ssid ) {
 			NEXTLINE( "Trying to connect" );
@@ -442,7 +2120,7 @@ void loop() {
 			NEXTLINE( "Unable to connect" );
 			NEXTLINE( "to WiFi network!" );
 		}
-		pocuter->Display->updateScreen();
+		UpdateScreen();
 		return;
 	}
 
@@ -453,6 +2131,9 @@ void loop() {
 		char xfer_bytes[24];
 		snprintf(xfer_bytes, 24, "%0.02f Kib", (float)www_image_size / 1024.0);		
 
+		char xfer_rate[24];
+		snprintf(xfer_rate, 24, "%0.1f KiB/s", www_rate / 1024.0);
+
 		uint top = 24;
 		uint margin = 6;
 		uint height = 12;
@@ -464,12 +2145,20 @@ void loop() {
 
 		gui->UG_SetForecolor( C_PLUM );		
 		CENTER_TEXT( top + 16, xfer_bytes );
+		CENTER_TEXT( top + 28, xfer_rate );
 
 		//NEXTLINE( xfer_bytes );
-		pocuter->Display->updateScreen();
+		UpdateScreen();
 		return;		
 	}
 
+	// boot: wifi association complete
+	static bool boot_wifi = false;
+	if( !boot_wifi ) {
+		bootPhase("wifi");
+		boot_wifi = true;
+	}
+
 	// wifi: show server ip address
 	const PocuterWIFI::ipInfo* info = pocuter->WIFI->getIpInfo();
 	if( info->ipV4 ) {
@@ -480,6 +2169,16 @@ void loop() {
 		gui->UG_SetForecolor( C_PLUM );
 		text_y += 2;		
 		NEXTLINE( addr );
+
+		// boot: dhcp address obtained -- server is reachable
+		static bool boot_ready = false;
+		if( !boot_ready ) {
+			bootPhase("ready");
+			boot_ready = true;
+		}
+
+		// wifi: store the access point and dhcp lease for the next restart
+		FastReconnectSave();
 	} 
 	
 	// wifi: waiting for ip address
@@ -492,5 +2191,12 @@ void loop() {
 	}
 
 	// update display
-	pocuter->Display->updateScreen();
+	UpdateScreen();
+
+	// hoist: setup and the first frame completed -- confirm staged uploader image, with or without a network
+	static bool hoist_ready = false;
+	if( !hoist_ready ) {
+		HoistReady();
+		hoist_ready = true;
+	}
 }
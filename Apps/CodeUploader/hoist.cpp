@@ -0,0 +1,125 @@
+// ========================================
+// INCLUDES
+// ========================================
+
+#include "hoist.h"
+#include "md5.h"
+
+// ========================================
+// MACROS
+// ========================================
+
+#define HOIST_PATH_SIZE     256
+#define HOIST_READ_SIZE     4096
+
+// ========================================
+// TYPES
+// ========================================
+
+// ========================================
+// PROTOTYPES
+// ========================================
+
+// ========================================
+// GLOBALS
+// ========================================
+
+const char* hoistStateNames[] = { "NONE", "STAGED", "LAUNCHED", "CONFIRMED", "ROLLBACK" };
+
+// ========================================
+// FUNCTIONS
+// ========================================
+
+// char* hoistPath( dest, maxLength, suffix ) :: path of the uploader image file + suffix
+char* hoistPath(char *dest, size_t maxLength, const char *suffix) {
+    snprintf(dest, maxLength, "%s/apps/%u/esp32c3.app%s", pocuter->SDCard->getMountPoint(), HOIST_UPLOADER_ID, suffix);
+    return dest;
+}
+
+// bool hoistRead( record ) :: read self-update record, returns false and defaults if missing
+bool hoistRead(HoistRecord *record) {
+    char path[HOIST_PATH_SIZE];
+    char state[16] = "";
+
+    memset(record, 0, sizeof(HoistRecord));
+
+    FILE *file = fopen(hoistPath(path, HOIST_PATH_SIZE, ".hoist"), "r");
+    if (!file)
+        return false;
+
+    int fields = fscanf(file, "State=%15s\nSize=%ld\nAttempts=%d\nMD5=%32s\n",
+        state, &record->size, &record->attempts, record->md5);
+    fclose(file);
+
+    for (uint i = 0; i < sizeof(hoistStateNames) / sizeof(hoistStateNames[0]); i++)
+        if (strcmp(state, hoistStateNames[i]) == 0)
+            record->state = (HoistState) i;
+
+    return fields >= 1;
+}
+
+// bool hoistWrite( record ) :: write self-update record
+bool hoistWrite(const HoistRecord *record) {
+    char path[HOIST_PATH_SIZE];
+
+    FILE *file = fopen(hoistPath(path, HOIST_PATH_SIZE, ".hoist"), "w");
+    if (!file)
+        return false;
+
+    fprintf(file, "State=%s\nSize=%ld\nAttempts=%d\nMD5=%s\n",
+        hoistStateNames[record->state], record->size, record->attempts, record->md5[0] ? record->md5 : "-");
+    fclose(file);
+    return true;
+}
+
+// bool hoistVerify( record ) :: verify size and md5 hash of the staged uploader image
+bool hoistVerify(const HoistRecord *record) {
+    char path[HOIST_PATH_SIZE];
+    uint8_t buffer[HOIST_READ_SIZE];
+    MD5 md5sum;
+    long size = 0;
+
+    FILE *file = fopen(hoistPath(path, HOIST_PATH_SIZE, ""), "r");
+    if (!file)
+        return false;
+
+    size_t bytes;
+    while ((bytes = fread(buffer, 1, HOIST_READ_SIZE, file)) > 0) {
+        md5sum.add(buffer, bytes);
+        size += bytes;
+    }
+    fclose(file);
+
+    return size == record->size && strcmp(md5sum.getHash().c_str(), record->md5) == 0;
+}
+
+// bool hoistInstalled( record ) :: the hash sidecar of the installed uploader image names the staged image
+bool hoistInstalled(const HoistRecord *record) {
+    char path[HOIST_PATH_SIZE];
+    char line[64] = "";
+
+    FILE *file = fopen(hoistPath(path, HOIST_PATH_SIZE, ".md5"), "r");
+    if (!file)
+        return false;
+    fgets(line, sizeof(line), file);
+    fclose(file);
+
+    return strncmp(line, record->md5, 32) == 0 && line[32] == ' ' && atol(line + 33) == record->size;
+}
+
+// bool hoistRollback() :: restore the uploader image from the backup file -- the hash sidecar belongs to the staged image
+bool hoistRollback() {
+    char path_image[HOIST_PATH_SIZE];
+    char path_backup[HOIST_PATH_SIZE];
+    char path_hash[HOIST_PATH_SIZE];
+    hoistPath(path_image, HOIST_PATH_SIZE, "");
+    hoistPath(path_backup, HOIST_PATH_SIZE, ".backup");
+    hoistPath(path_hash, HOIST_PATH_SIZE, ".md5");
+
+    if (access(path_backup, F_OK) != 0)
+        return false;
+
+    remove(path_hash);
+    remove(path_image);
+    return rename(path_backup, path_image) == 0;
+}
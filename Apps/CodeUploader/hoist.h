@@ -0,0 +1,56 @@
+#ifndef _HOIST_H_
+#define _HOIST_H_
+// ========================================
+// INCLUDES
+// ========================================
+
+#include "system.h"
+
+// ========================================
+// MACROS
+// ========================================
+
+#define HOIST_UPLOADER_ID       8080
+#define HOIST_PROXY_ID          8081
+#define HOIST_MAX_ATTEMPTS      3
+
+// ========================================
+// TYPES
+// ========================================
+
+enum HoistState {
+    HOIST_STATE_NONE,
+    HOIST_STATE_STAGED,
+    HOIST_STATE_LAUNCHED,
+    HOIST_STATE_CONFIRMED,
+    HOIST_STATE_ROLLBACK,
+};
+
+struct HoistRecord {
+    HoistState state;
+    long size;              // size of the staged image
+    int attempts;           // boots of the staged image that haven't reached the ready state
+    char md5[33];           // md5 hash of the staged image
+};
+
+// ========================================
+// PROTOTYPES
+// ========================================
+
+extern char* hoistPath(char *dest, size_t maxLength, const char *suffix);
+extern bool  hoistRead(HoistRecord *record);
+extern bool  hoistWrite(const HoistRecord *record);
+extern bool  hoistVerify(const HoistRecord *record);
+extern bool  hoistInstalled(const HoistRecord *record);
+extern bool  hoistRollback();
+
+// ========================================
+// GLOBALS
+// ========================================
+
+// ========================================
+// FUNCTIONS
+// ========================================
+
+
+#endif //_HOIST_H_
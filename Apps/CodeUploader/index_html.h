@@ -463,8 +463,9 @@ function UploadFile() {
         $('button').style.display = 'block';
     };
 
-    // Initiate a multipart/form-data upload
-    xreq.open( "POST", '/upload', true );
+    // Initiate a multipart/form-data upload -- the query string lets the server refuse the image before the body
+    const query = new URLSearchParams({ appID: imageFile.appid, appSize: imageFile.size, appMD5: imageFile.md5sum });
+    xreq.open( "POST", '/upload?' + query.toString(), true );
     xreq.send( params );
 }
 
@@ -0,0 +1,340 @@
+// ========================================
+// INCLUDES
+// ========================================
+
+#include "sdservice.h"
+#include "system.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <ff.h>
+
+// ========================================
+// MACROS
+// ========================================
+
+#define SDSERVICE_PATH_MAX      64
+
+// ========================================
+// TYPES
+// ========================================
+
+enum SDServiceCommand {
+    SDSERVICE_CMD_MOUNT,
+    SDSERVICE_CMD_UNMOUNT,
+    SDSERVICE_CMD_UNMOUNT_FORCE,
+};
+
+struct SDServiceFile {
+    FILE* file;
+    char path[SDSERVICE_PATH_MAX];
+};
+
+// ========================================
+// PROTOTYPES
+// ========================================
+
+static void sdServiceTask(void *arg);
+
+// ========================================
+// GLOBALS
+// ========================================
+
+static QueueHandle_t commands = NULL;
+static QueueHandle_t events = NULL;
+static SemaphoreHandle_t filesLock = NULL;
+static SDServiceFile files[SDSERVICE_MAX_FILES];
+
+static volatile SDServiceState state = SDSERVICE_NO_CARD;
+static volatile int64_t operationStart = 0;
+static bool autoMountCard = false;
+static volatile int fatDrive = -1;     // fatfs drive of the mounted card, -1: not resolved since the last mount
+
+// ========================================
+// FUNCTIONS
+// ========================================
+
+void sdServiceBegin(bool autoMount) {
+    if (commands)
+        return;
+
+    autoMountCard = autoMount;
+    commands = xQueueCreate(SDSERVICE_QUEUE_SIZE, sizeof(uint8_t));
+    events = xQueueCreate(SDSERVICE_QUEUE_SIZE, sizeof(SDServiceEvent));
+    filesLock = xSemaphoreCreateMutex();
+
+    if (pocuter->SDCard->cardIsMounted())
+        state = SDSERVICE_MOUNTED;
+    else
+        state = pocuter->SDCard->cardInSlot() ? SDSERVICE_UNMOUNTED : SDSERVICE_NO_CARD;
+
+    xTaskCreate(sdServiceTask, "sdservice", SDSERVICE_TASK_STACK, NULL, SDSERVICE_TASK_PRIORITY, NULL);
+}
+
+static void sdServicePost(SDServiceEventType type, uint32_t us = 0, int openFiles = 0, FILE **dropped = NULL) {
+    SDServiceEvent event = { type, us, openFiles };
+    if (dropped)
+        memcpy(event.files, dropped, sizeof(event.files));
+    printf("SDSERVICE: %s", sdServiceEventName(type));
+    if (us)
+        printf(" in %u ms", us / 1000);
+    if (openFiles)
+        printf(" (%d open files)", openFiles);
+    printf("\n");
+    xQueueSend(events, &event, 0);
+    schedulerWake(WAKE_SDCARD);
+}
+
+static SDServiceState sdServiceIdleState() {
+    if (pocuter->SDCard->cardIsMounted())
+        return SDSERVICE_MOUNTED;
+    return pocuter->SDCard->cardInSlot() ? SDSERVICE_UNMOUNTED : SDSERVICE_NO_CARD;
+}
+
+static int sdServiceFlush() {
+    // flush + sync every tracked file so an unmount doesn't lose buffered data
+    int count = 0;
+    xSemaphoreTake(filesLock, portMAX_DELAY);
+    for (int i = 0; i < SDSERVICE_MAX_FILES; i++) {
+        if (!files[i].file)
+            continue;
+        fflush(files[i].file);
+        fsync(fileno(files[i].file));
+        printf("SDSERVICE: open file: %s\n", files[i].path);
+        count++;
+    }
+    xSemaphoreGive(filesLock);
+    return count;
+}
+
+static int sdServiceList(FILE **removed) {
+    // card removed: list the open files for their owners, they stay tracked until closed
+    int count = 0;
+    xSemaphoreTake(filesLock, portMAX_DELAY);
+    for (int i = 0; i < SDSERVICE_MAX_FILES; i++) {
+        removed[i] = files[i].file;
+        if (files[i].file)
+            count++;
+    }
+    xSemaphoreGive(filesLock);
+    return count;
+}
+
+static void sdServiceDrop() {
+    // card removed: wait for the owners to close their files, then stop tracking the rest without touching them
+    for (int waited = 0; sdServiceOpenFiles() && waited < SDSERVICE_REMOVE_WAIT; waited += 10)
+        vTaskDelay(pdMS_TO_TICKS(10));
+
+    xSemaphoreTake(filesLock, portMAX_DELAY);
+    for (int i = 0; i < SDSERVICE_MAX_FILES; i++) {
+        if (!files[i].file)
+            continue;
+        printf("SDSERVICE: lost file: %s\n", files[i].path);
+        files[i].file = NULL;
+    }
+    xSemaphoreGive(filesLock);
+}
+
+static void sdServiceDoMount() {
+    if (pocuter->SDCard->cardIsMounted()) {
+        state = SDSERVICE_MOUNTED;
+        return;
+    }
+
+    operationStart = esp_timer_get_time();
+    state = SDSERVICE_MOUNTING;
+    fatDrive = -1;
+    pocuter->SDCard->mount();
+    uint32_t us = esp_timer_get_time() - operationStart;
+
+    state = sdServiceIdleState();
+    sdServicePost(state == SDSERVICE_MOUNTED ? SDSERVICE_EVENT_MOUNTED : SDSERVICE_EVENT_MOUNT_FAILED, us);
+}
+
+static void sdServiceDoUnmount(bool force, bool flush = true) {
+    if (!pocuter->SDCard->cardIsMounted()) {
+        state = sdServiceIdleState();
+        return;
+    }
+
+    int openFiles = flush ? sdServiceFlush() : 0;
+    if (openFiles && !force) {
+        sdServicePost(SDSERVICE_EVENT_FILES_OPEN, 0, openFiles);
+        return;
+    }
+
+    operationStart = esp_timer_get_time();
+    state = SDSERVICE_UNMOUNTING;
+    fatDrive = -1;
+    pocuter->SDCard->unmount();
+    uint32_t us = esp_timer_get_time() - operationStart;
+
+    state = sdServiceIdleState();
+    sdServicePost(SDSERVICE_EVENT_UNMOUNTED, us, openFiles);
+}
+
+static void sdServiceTask(void *arg) {
+    bool inSlot = pocuter->SDCard->cardInSlot();
+    int samples = 0;
+
+    for (;;) {
+        // worker: mount/unmount requests, waiting at most one poll interval
+        uint8_t command;
+        if (xQueueReceive(commands, &command, pdMS_TO_TICKS(SDSERVICE_POLL_MS)) == pdTRUE) {
+            if (command == SDSERVICE_CMD_MOUNT)
+                sdServiceDoMount();
+            else
+                sdServiceDoUnmount(command == SDSERVICE_CMD_UNMOUNT_FORCE);
+            continue;
+        }
+
+        // detect: debounced card slot poll
+        bool sample = pocuter->SDCard->cardInSlot();
+        if (sample == inSlot) {
+            samples = 0;
+            continue;
+        }
+        if (++samples < SDSERVICE_DEBOUNCE)
+            continue;
+        inSlot = sample;
+        samples = 0;
+
+        if (inSlot) {
+            state = sdServiceIdleState();
+            sdServicePost(SDSERVICE_EVENT_INSERTED);
+            if (autoMountCard)
+                sdServiceDoMount();
+        } else {
+            // removed: hand the open files to their owners and let them close them, then drop the stale
+            // mount without flushing -- a file still written by its owner isn't unmounted under it
+            FILE *removed[SDSERVICE_MAX_FILES];
+            int openFiles = sdServiceList(removed);
+            sdServicePost(SDSERVICE_EVENT_REMOVED, 0, openFiles, removed);
+            sdServiceDrop();
+            sdServiceDoUnmount(true, false);
+            state = SDSERVICE_NO_CARD;
+        }
+    }
+}
+
+bool sdServiceGetEvent(SDServiceEvent *event) {
+    return events && xQueueReceive(events, event, 0) == pdTRUE;
+}
+
+void sdServiceMount() {
+    uint8_t command = SDSERVICE_CMD_MOUNT;
+    xQueueSend(commands, &command, 0);
+}
+
+void sdServiceUnmount(bool force) {
+    uint8_t command = force ? SDSERVICE_CMD_UNMOUNT_FORCE : SDSERVICE_CMD_UNMOUNT;
+    xQueueSend(commands, &command, 0);
+}
+
+SDServiceState sdServiceState() {
+    return state;
+}
+
+bool sdServiceIsMounted() {
+    return state == SDSERVICE_MOUNTED;
+}
+
+uint32_t sdServiceElapsed() {
+    if (state != SDSERVICE_MOUNTING && state != SDSERVICE_UNMOUNTING)
+        return 0;
+    return esp_timer_get_time() - operationStart;
+}
+
+const char* sdServiceEventName(SDServiceEventType type) {
+    switch (type) {
+        case SDSERVICE_EVENT_INSERTED:      return "card inserted";
+        case SDSERVICE_EVENT_REMOVED:       return "card removed";
+        case SDSERVICE_EVENT_MOUNTED:       return "mounted";
+        case SDSERVICE_EVENT_MOUNT_FAILED:  return "mount failed";
+        case SDSERVICE_EVENT_UNMOUNTED:     return "unmounted";
+        case SDSERVICE_EVENT_FILES_OPEN:    return "files open";
+    }
+    return "";
+}
+
+bool sdServiceFatDrive(char *drive) {
+    // the vfs doesn't tell which fatfs drive holds the mount point: a probe file written through the vfs is
+    // looked up on every fatfs drive, once per mount
+    if (fatDrive < 0) {
+        char path[64], token[20];
+        snprintf(path, sizeof(path), "%s/" SDSERVICE_DRIVE_PROBE, pocuter->SDCard->getMountPoint());
+        snprintf(token, sizeof(token), "%08x%08x", esp_random(), esp_random());
+        FILE *file = fopen(path, "w");
+        if (!file)
+            return false;
+        bool written = fputs(token, file) >= 0;
+        if (fclose(file) != 0 || !written) {
+            remove(path);
+            return false;
+        }
+
+        for (int i = 0; i < FF_VOLUMES && fatDrive < 0; i++) {
+            char ffpath[32], text[sizeof(token)] = "";
+            FIL probe;
+            UINT len = 0;
+            snprintf(ffpath, sizeof(ffpath), "%d:/" SDSERVICE_DRIVE_PROBE, i);
+            if (f_open(&probe, ffpath, FA_READ) != FR_OK)
+                continue;
+            f_read(&probe, text, sizeof(text) - 1, &len);
+            f_close(&probe);
+            text[len] = '\0';
+            if (strcmp(text, token) == 0)
+                fatDrive = i;
+        }
+        remove(path);
+        if (fatDrive < 0)
+            return false;
+    }
+    sprintf(drive, "%d:", fatDrive);
+    return true;
+}
+
+FILE* sdOpen(const char *path, const char *mode) {
+    FILE *file = fopen(path, mode);
+    if (!file || !filesLock)
+        return file;
+
+    xSemaphoreTake(filesLock, portMAX_DELAY);
+    int i = 0;
+    while (i < SDSERVICE_MAX_FILES && files[i].file)
+        i++;
+    if (i < SDSERVICE_MAX_FILES) {
+        files[i].file = file;
+        strncpy(files[i].path, path, SDSERVICE_PATH_MAX - 1);
+        files[i].path[SDSERVICE_PATH_MAX - 1] = '\0';
+    } else {
+        printf("SDSERVICE: too many open files, not tracking %s\n", path);
+    }
+    xSemaphoreGive(filesLock);
+    return file;
+}
+
+int sdClose(FILE *file) {
+    if (filesLock) {
+        xSemaphoreTake(filesLock, portMAX_DELAY);
+        for (int i = 0; i < SDSERVICE_MAX_FILES; i++) {
+            if (files[i].file == file)
+                files[i].file = NULL;
+        }
+        xSemaphoreGive(filesLock);
+    }
+    return fclose(file);
+}
+
+int sdServiceOpenFiles() {
+    if (!filesLock)
+        return 0;
+
+    int count = 0;
+    xSemaphoreTake(filesLock, portMAX_DELAY);
+    for (int i = 0; i < SDSERVICE_MAX_FILES; i++) {
+        if (files[i].file)
+            count++;
+    }
+    xSemaphoreGive(filesLock);
+    return count;
+}
@@ -6,6 +6,12 @@
 
 #include "settings.h"
 #include "system.h"
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <new>
+#if SETTINGS_KVSTORE
+#include "KVStore.h"
+#endif
 
 // ========================================
 // MACROS
@@ -17,6 +23,24 @@
 // TYPES
 // ========================================
 
+struct SettingsFile {
+    SettingsFile *next;
+    char *name;
+    PocuterConfig *config;
+#if SETTINGS_KVSTORE
+    PocuterUtil::KVStore *store;
+#endif
+};
+
+struct SettingsEntry {
+    SettingsEntry *next;
+    SettingsFile *file;
+    char *section;
+    char *name;
+    char *value;        // NULL: not set in the file
+    bool dirty;
+};
+
 // ========================================
 // PROTOTYPES
 // ========================================
@@ -29,13 +53,250 @@ PocuterSettings pocuterSettings;
 
 char numBuffer[NUM_BUFFER_SIZE];
 
+static SettingsStats settingsStats;
+static SettingsFile *settingsFiles = NULL;
+static SettingsEntry *settingsEntries = NULL;
+static SemaphoreHandle_t settingsLock = NULL;
+static TaskHandle_t settingsTask = NULL;
+
 // ========================================
 // FUNCTIONS
 // ========================================
 
+static void settingsFlushTask(void *arg) {
+    // debounce: flush once no change arrived for the flush delay -- the sd card is written by this task, not by the caller
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SETTINGS_FLUSH_DELAY)))
+            ;
+        if (!flushSettings())
+            printf("SETTINGS: flush failed, %u values kept for the next flush\n", settingsStats.dirty);
+    }
+}
+
+static void settingsShutdown() {
+    flushSettings();
+}
+
+static void settingsBegin() {
+    // first call: lock, flush task, and flush on restart -- apps exit by restarting
+    settingsLock = xSemaphoreCreateMutex();
+#if SETTINGS_CACHE
+    xTaskCreate(settingsFlushTask, "settings", SETTINGS_TASK_STACK, NULL, SETTINGS_TASK_PRIORITY, &settingsTask);
+#endif
+    esp_register_shutdown_handler(settingsShutdown);
+}
+
+static SettingsFile* settingsFile(const char *file) {
+    SettingsFile *entry = settingsFiles;
+    while (entry && strcmp(entry->name, file) != 0)
+        entry = entry->next;
+    if (entry)
+        return entry;
+
+    // open: one config object per file for the lifetime of the app, NULL without memory
+    entry = new (std::nothrow) SettingsFile();
+    if (!entry)
+        return NULL;
+    entry->name = strdup(file);
+    entry->config = entry->name ? new (std::nothrow) PocuterConfig((const uint8_t *) entry->name) : NULL;
+#if SETTINGS_KVSTORE
+    char path[96];
+    snprintf(path, sizeof(path), "%s/apps/%llu/%s.kvl", pocuter->SDCard->getMountPoint(), pocuter->OTA->getCurrentAppID(), file);
+    entry->store = entry->config ? new (std::nothrow) PocuterUtil::KVStore(path) : NULL;
+    if (entry->store) {
+        entry->store->open();
+    } else {
+        delete entry->config;
+        entry->config = NULL;
+    }
+#endif
+    if (!entry->config) {
+        free(entry->name);
+        delete entry;
+        return NULL;
+    }
+    entry->next = settingsFiles;
+    settingsFiles = entry;
+    return entry;
+}
+
+static bool settingsFileGet(SettingsFile *config, const char *section, const char *name, char *dest, size_t maxLength) {
+    settingsStats.fileReads++;
+#if SETTINGS_KVSTORE
+    // log: keys are "section/name", a value missing from the log is migrated from the ini file
+    char key[KVSTORE_KEY_MAX + 1];
+    snprintf(key, sizeof(key), "%s/%s", section, name);
+    if (config->store->get(key, dest, maxLength))
+        return true;
+    bool found = config->config->get((const uint8_t *) section, (const uint8_t *) name, (uint8_t *) dest, maxLength);
+    if (found)
+        config->store->put(key, dest);
+    return found;
+#else
+    return config->config->get((const uint8_t *) section, (const uint8_t *) name, (uint8_t *) dest, maxLength);
+#endif
+}
+
+static bool settingsFileSet(SettingsFile *config, const char *section, const char *name, const char *value) {
+    settingsStats.fileWrites++;
+#if SETTINGS_KVSTORE
+    // log: the ini file is only written when the log can't be opened
+    if (config->store->isOpen()) {
+        char key[KVSTORE_KEY_MAX + 1];
+        snprintf(key, sizeof(key), "%s/%s", section, name);
+        return config->store->put(key, value);
+    }
+#endif
+    return config->config->set((const uint8_t *) section, (const uint8_t *) name, (const uint8_t *) value);
+}
+
+static void settingsEntryFree(SettingsEntry *entry) {
+    free(entry->section);
+    free(entry->name);
+    free(entry->value);
+    delete entry;
+}
+
+static SettingsEntry* settingsEntry(const char *file, const char *section, const char *name, bool load) {
+    // NULL without memory -- nothing is cached, the caller reads or writes the file directly or fails
+    SettingsFile *config = settingsFile(file);
+    if (!config)
+        return NULL;
+    SettingsEntry *entry = settingsEntries;
+    while (entry && !(entry->file == config && strcmp(entry->section, section) == 0 && strcmp(entry->name, name) == 0))
+        entry = entry->next;
+    if (entry)
+        return entry;
+
+    entry = new (std::nothrow) SettingsEntry();
+    if (!entry)
+        return NULL;
+    entry->file = config;
+    entry->section = strdup(section);
+    entry->name = strdup(name);
+    entry->value = NULL;
+    entry->dirty = false;
+    if (!entry->section || !entry->name) {
+        settingsEntryFree(entry);
+        return NULL;
+    }
+
+    // load: read the value once, missing values are cached too
+    if (load) {
+        char value[SETTINGS_VALUE_MAX];
+        memset(value, 0, SETTINGS_VALUE_MAX);
+        if (settingsFileGet(config, section, name, value, SETTINGS_VALUE_MAX) && !(entry->value = strdup(value))) {
+            settingsEntryFree(entry);
+            return NULL;
+        }
+    }
+    entry->next = settingsEntries;
+    settingsEntries = entry;
+    return entry;
+}
+
+bool getConfigSetting(const char *file, const char *section, const char *name, char *dest, size_t maxLength) {
+    int64_t start = esp_timer_get_time();
+    settingsStats.reads++;
+
+    if (!settingsLock)
+        settingsBegin();
+    xSemaphoreTake(settingsLock, portMAX_DELAY);
+#if SETTINGS_CACHE
+    SettingsEntry *entry = settingsEntry(file, section, name, true);
+    bool found = entry && entry->value != NULL;
+    if (found) {
+        strncpy(dest, entry->value, maxLength - 1);
+        dest[maxLength - 1] = '\0';
+    } else if (!entry) {
+        SettingsFile *config = settingsFile(file);
+        found = config && settingsFileGet(config, section, name, dest, maxLength);
+    }
+#else
+    SettingsFile *config = settingsFile(file);
+    bool found = config && settingsFileGet(config, section, name, dest, maxLength);
+#endif
+    xSemaphoreGive(settingsLock);
+
+    settingsStats.readUs += esp_timer_get_time() - start;
+    return found;
+}
+
+bool setConfigSetting(const char *file, const char *section, const char *name, const char *value) {
+    // size: a longer value would be cut off by the next load, reject it instead
+    if (strlen(value) >= SETTINGS_VALUE_MAX)
+        return false;
+
+    int64_t start = esp_timer_get_time();
+    settingsStats.writes++;
+
+    if (!settingsLock)
+        settingsBegin();
+    xSemaphoreTake(settingsLock, portMAX_DELAY);
+#if SETTINGS_CACHE
+    // cache: the entry only turns dirty once it holds its copy of the value
+    SettingsEntry *entry = settingsEntry(file, section, name, false);
+    bool result = entry != NULL;
+    bool changed = result && (!entry->value || strcmp(entry->value, value) != 0);
+    if (changed) {
+        char *copy = strdup(value);
+        if (copy) {
+            if (!entry->dirty)
+                settingsStats.dirty++;
+            free(entry->value);
+            entry->value = copy;
+            entry->dirty = true;
+        } else {
+            result = changed = false;
+        }
+    }
+    xSemaphoreGive(settingsLock);
+
+    // debounce: every change restarts the flush delay of the flush task
+    if (changed && settingsTask)
+        xTaskNotifyGive(settingsTask);
+#else
+    SettingsFile *config = settingsFile(file);
+    bool result = config && settingsFileSet(config, section, name, value);
+    xSemaphoreGive(settingsLock);
+#endif
+
+    settingsStats.writeUs += esp_timer_get_time() - start;
+    return result;
+}
+
+bool flushSettings() {
+    if (!settingsLock)
+        return true;
+
+    // write: changed values, failed writes stay dirty for the next flush
+    int64_t start = esp_timer_get_time();
+    bool result = true;
+    xSemaphoreTake(settingsLock, portMAX_DELAY);
+    for (SettingsEntry *entry = settingsEntries; entry; entry = entry->next) {
+        if (!entry->dirty)
+            continue;
+        entry->dirty = !settingsFileSet(entry->file, entry->section, entry->name, entry->value);
+        if (entry->dirty) {
+            settingsStats.failedWrites++;
+            result = false;
+        } else {
+            settingsStats.dirty--;
+        }
+    }
+    xSemaphoreGive(settingsLock);
+
+    settingsStats.writeUs += esp_timer_get_time() - start;
+    return result;
+}
+
+const SettingsStats* getSettingsStats() {
+    return &settingsStats;
+}
+
 bool getSetting(const char *section, const char *name, char *dest, size_t maxLength) {
-    PocuterConfig config((const uint8_t *) "settings");
-    return config.get((const uint8_t *) section, (const uint8_t *) name, (uint8_t *) dest, maxLength);
+    return getConfigSetting(SETTINGS_FILE, section, name, dest, maxLength);
 }
 
 char* getSetting(const char *section, const char *name, const char *defaultValue, char *dest, size_t maxLength) {
@@ -65,8 +326,7 @@ double getSetting(const char *section, const char *name, double defaultValue) {
 }
 
 bool setSetting(const char *section, const char *name, const char *value) {
-    PocuterConfig config((const uint8_t *) "settings");
-    return config.set((const uint8_t *) section, (const uint8_t *) name, (const uint8_t *) value);
+    return setConfigSetting(SETTINGS_FILE, section, name, value);
 }
 
 bool setSetting(const char *section, const char *name, int value) {
@@ -1,5 +1,6 @@
 #include "settings.h"
 #include "system.h"
+#include "hoist.h"
 
 long lastFrame;
 void setup() {
@@ -24,12 +25,35 @@ void setup() {
     printf("... Code Uploader Self-Hoisting Boot Proxy ...\n");
     printf("**********************************************\n");
 
+    // verify: staged uploader image -- roll back to the backup image on failure
+    HoistRecord record;
+    if( hoistRead( &record ) ) {
+        if( record.state == HOIST_STATE_STAGED ) {
+            if( hoistVerify( &record ) ) {
+                printf("HOIST: Verified staged image %s\n", record.md5 );
+                record.state = HOIST_STATE_LAUNCHED;
+                record.attempts = 0;
+            } else {
+                printf("HOIST: Staged image doesn't match %s, rolling back...\n", record.md5 );
+                hoistRollback();
+                record.state = HOIST_STATE_NONE;
+            }
+            hoistWrite( &record );
+        }
+        else if( record.state == HOIST_STATE_ROLLBACK ) {
+            printf("HOIST: Rolling back to backup image...\n");
+            hoistRollback();
+            record.state = HOIST_STATE_NONE;
+            hoistWrite( &record );
+        }
+    }
+
     delay(100);  
 }
 
 // launch: Code Uploader application 
 void loop() { 
-    pocuter->OTA->setNextAppID( 8080 );
+    pocuter->OTA->setNextAppID( HOIST_UPLOADER_ID );
     pocuter->OTA->restart();      
     delay(1000); 
 }
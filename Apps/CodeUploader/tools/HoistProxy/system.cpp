@@ -3,6 +3,8 @@
 // ========================================
 
 #include "system.h"
+#include <sys/time.h>
+#include <esp_timer.h>
 
 // ========================================
 // MACROS
@@ -13,6 +15,21 @@
 #define ENTER_HOLD_MS       300
 #define REPEAT_HOLD_MS      100
 
+#define INPUT_SAMPLE_US     1000    // button sampling period of the input timer
+#define INPUT_DEBOUNCE_US   10000   // changes of a button are ignored for this long after an edge
+#define INPUT_QUEUE_SIZE    32      // button events buffered between updateInput() calls, power of two
+
+#define SCHEDULER_TIMERS        8
+#define SCHEDULER_DEFAULT_FPS   30
+#define SCHEDULER_ACTIVE_MS     1000    // frames run at the active rate for this long after a wake event
+
+#define BOOT_PHASE_MAGIC    0x424F4F54
+
+#define PROFILE_HUD_LINES   4
+
+#define TRACE_TASK_NAME     16      // configMAX_TASK_NAME_LEN
+#define TRACE_LINE          64
+
 // ========================================
 // TYPES
 // ========================================
@@ -30,6 +47,36 @@ struct ButtonDetectionHandler {
     long lastEventTime;
     uint8_t input;
     bool doubleClickEnabled;
+    bool earlyClickEnabled;
+    uint16_t clickTimeout;  // ms, 0: CLICK_TIMEOUT_MS
+    uint16_t holdTimeout;   // ms, 0: ENTER_HOLD_MS
+    int64_t releaseTime;    // us of the last releasing edge
+    bool releasePending;    // release stepped after the hold timeout -- the hold is reported first, the release next frame
+};
+
+struct InputEvent {
+    int64_t us;             // esp_timer time of the edge
+    uint8_t state;          // button state after the edge
+};
+
+struct SchedulerTimer {
+    void (*callback)(void *arg);
+    void *arg;
+    uint32_t periodMs;      // 0: one-shot
+    int64_t due;            // esp_timer time of the next call
+};
+
+struct BootPhase {
+    char name[BOOT_PHASE_NAME];
+    uint32_t us;            // micros() since boot
+    int64_t wall;           // wall clock, preserved by the rtc across software restarts
+};
+
+struct BootPhaseLog {
+    uint32_t magic;
+    uint8_t count;
+    uint8_t dumped;
+    BootPhase phases[BOOT_PHASE_MAX];
 };
 
 // ========================================
@@ -45,6 +92,51 @@ double dt;
 uint8_t lastButtonState;
 ButtonDetectionHandler buttonHandler[BUTTON_COUNT];
 
+// button edges: single producer (input timer), single consumer (updateInput)
+static InputEvent inputQueue[INPUT_QUEUE_SIZE];
+static uint32_t inputHead = 0;
+static uint32_t inputTail = 0;
+static uint8_t inputSampled = 0;
+static int64_t inputEdgeTime[BUTTON_COUNT];
+static esp_timer_handle_t inputTimer = NULL;
+static bool inputStarted = false;
+static InputStats inputStats;
+
+// frame scheduler of the loop() task
+static TaskHandle_t schedulerTask = NULL;
+static SchedulerTimer schedulerTimers[SCHEDULER_TIMERS];
+static uint16_t schedulerFps = SCHEDULER_DEFAULT_FPS;
+static uint16_t schedulerIdleFps = SCHEDULER_DEFAULT_FPS;
+static int64_t schedulerFrameStart = 0;
+static int64_t schedulerActiveUntil = 0;
+static SchedulerStats schedulerStats;
+
+// frame profiler: sections are only updated from the loop() task
+#if PROFILER
+static ProfileStats profileWindow;
+static ProfileStats profileLast;
+static int profileSlots = 0;
+static int64_t profileFrameStart = 0;
+static int64_t profileWindowStart = 0;
+static int64_t profileReportStart = 0;
+static bool profileHudShown = false;
+#endif
+
+// trace recorder: events are recorded from any task, the ring is read while recording is paused
+#if TRACE
+static TraceEvent traceEvents[TRACE_EVENTS];
+static uint32_t traceSeq[TRACE_EVENTS];     // claim index + 1 of the complete event in the slot, 0 while it's written
+static uint32_t traceHead = 0;
+static bool traceEnabled = true;
+static const char *traceNames[TRACE_NAMES];
+static TaskHandle_t traceTasks[TRACE_TASKS];
+static char traceTaskNames[TRACE_TASKS][TRACE_TASK_NAME];
+#endif
+
+// boot phase logs of the current and previous boot, retained in rtc memory across restarts
+RTC_NOINIT_ATTR BootPhaseLog bootPhaseLog[2];
+bool bootPhaseStarted = false;
+
 // ========================================
 // FUNCTIONS
 // ========================================
@@ -59,79 +151,226 @@ void disableDoubleClick(int bt) {
         buttonHandler[bt].doubleClickEnabled = false;
 }
 
-void updateInput() {
-    long ms = millis();
-    uint8_t currentButtonState = pocuter->Buttons->getButtonState();
+void enableEarlyClick(int bt) {
+    if (0 <= bt && bt < BUTTON_COUNT)
+        buttonHandler[bt].earlyClickEnabled = true;
+}
+
+void disableEarlyClick(int bt) {
+    if (0 <= bt && bt < BUTTON_COUNT)
+        buttonHandler[bt].earlyClickEnabled = false;
+}
 
+void setClickTimeout(int bt, uint16_t clickMs, uint16_t holdMs) {
+    if (0 <= bt && bt < BUTTON_COUNT) {
+        buttonHandler[bt].clickTimeout = clickMs;
+        buttonHandler[bt].holdTimeout = holdMs;
+    }
+}
+
+static ClickMode clickMode(ButtonDetectionHandler *handler) {
+    if (!handler->doubleClickEnabled)
+        return CLICK_MODE_SINGLE;
+    return handler->earlyClickEnabled ? CLICK_MODE_EARLY : CLICK_MODE_DOUBLE;
+}
+
+static void inputSample(void *arg) {
+    int64_t us = esp_timer_get_time();
+    uint8_t state = pocuter->Buttons->getButtonState();
+
+    // debounce: accept an edge at once, then ignore the button until it settled
+    uint8_t changed = state ^ inputSampled;
     for (int i = 0; i < BUTTON_COUNT; i++) {
-        ButtonDetectionHandler *handler = &buttonHandler[i];
-        
-        bool currentState = currentButtonState & (1 << i);
-        bool lastState    = lastButtonState    & (1 << i);
-        
-        bool pressed  = !lastState &&  currentState;
-        bool released =  lastState && !currentState;
-
-        handler->input = 0;
-
-        ButtonDetectionState newState = handler->state;
-        switch (handler->state) {
-            default:
-            case BUTTON_STATE_IDLE:
-                if (pressed)
-                    newState = BUTTON_STATE_PRESSED;
-                break;
-            case BUTTON_STATE_PRESSED:
-                if (released) {
-                    if (!handler->doubleClickEnabled) {
-                        handler->input = SINGLE_CLICK;
-                        newState = BUTTON_STATE_IDLE;
-                    } else
-                        newState = BUTTON_STATE_SINGLE_CLICK;
-                } else {
-                    if (ms - handler->lastEventTime > ENTER_HOLD_MS) {
-                        handler->input = HOLD;
-                        newState = BUTTON_STATE_HOLD;
-                    }
-                }
-                break;
-            case BUTTON_STATE_HOLD:
-                if (released) {
-                    if (!handler->doubleClickEnabled) {
-                        handler->input = SINGLE_CLICK;
-                        newState = BUTTON_STATE_IDLE;
-                    } else
-                        newState = BUTTON_STATE_SINGLE_CLICK;
+        if ((changed & (1 << i)) && us - inputEdgeTime[i] < INPUT_DEBOUNCE_US)
+            changed &= ~(1 << i);
+    }
+    if (!changed)
+        return;
+
+    // full queue: the edge is sampled again on the next tick
+    uint32_t head = inputHead;
+    if (head - __atomic_load_n(&inputTail, __ATOMIC_ACQUIRE) >= INPUT_QUEUE_SIZE) {
+        inputStats.overflows++;
+        return;
+    }
+    inputSampled ^= changed;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        if (changed & (1 << i))
+            inputEdgeTime[i] = us;
+    }
+    inputQueue[head % INPUT_QUEUE_SIZE] = { us, inputSampled };
+    __atomic_store_n(&inputHead, head + 1, __ATOMIC_RELEASE);
+    inputStats.events++;
+    TRACE_COUNTER("buttons", inputSampled);
+    schedulerWake(WAKE_BUTTON);
+}
+
+static void inputBegin() {
+    // first call: sample the buttons from a timer so taps between frames aren't lost
+    inputStarted = true;
+    inputSampled = lastButtonState = pocuter->Buttons->getButtonState();
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = inputSample;
+    timerArgs.name = "input";
+    if (esp_timer_create(&timerArgs, &inputTimer) != ESP_OK || esp_timer_start_periodic(inputTimer, INPUT_SAMPLE_US) != ESP_OK)
+        inputTimer = NULL;
+}
+
+static uint8_t updateButton(ButtonDetectionHandler *handler, bool pressed, bool released, long ms) {
+    long clickTimeout = handler->clickTimeout ? handler->clickTimeout : CLICK_TIMEOUT_MS;
+    long holdTimeout = handler->holdTimeout ? handler->holdTimeout : ENTER_HOLD_MS;
+    uint8_t early = handler->earlyClickEnabled ? SINGLE_CLICK | CLICK_PROVISIONAL : 0;
+    uint8_t input = 0;
+    ButtonDetectionState newState = handler->state;
+    switch (handler->state) {
+        default:
+        case BUTTON_STATE_IDLE:
+            if (pressed)
+                newState = BUTTON_STATE_PRESSED;
+            break;
+        case BUTTON_STATE_PRESSED:
+            // hold first: a release queued behind a long frame may come after the hold timeout
+            if (ms - handler->lastEventTime > holdTimeout) {
+                input = HOLD;
+                newState = BUTTON_STATE_HOLD;
+                handler->releasePending = released;
+            } else if (released) {
+                if (!handler->doubleClickEnabled) {
+                    input = SINGLE_CLICK;
+                    newState = BUTTON_STATE_IDLE;
                 } else {
-                    if (ms - handler->lastEventTime > REPEAT_HOLD_MS) {
-                        handler->input = HOLD;
-                    }
+                    input = early;
+                    newState = BUTTON_STATE_SINGLE_CLICK;
                 }
-                break;
-            case BUTTON_STATE_SINGLE_CLICK:
-                if (pressed)
-                    newState = BUTTON_STATE_SINGLE_CLICK_THEN_PRESSED;
-                if (ms - handler->lastEventTime > CLICK_TIMEOUT_MS) {
-                    handler->input = SINGLE_CLICK;
+            }
+            break;
+        case BUTTON_STATE_HOLD:
+            if (released || handler->releasePending) {
+                handler->releasePending = false;
+                if (!handler->doubleClickEnabled) {
+                    input = SINGLE_CLICK;
                     newState = BUTTON_STATE_IDLE;
+                } else {
+                    input = early;
+                    newState = BUTTON_STATE_SINGLE_CLICK;
                 }
-                break;
-            case BUTTON_STATE_SINGLE_CLICK_THEN_PRESSED:
-                if (released) {
-                    handler->input = DOUBLE_CLICK;
-                    newState = BUTTON_STATE_IDLE;
+            } else {
+                if (ms - handler->lastEventTime > REPEAT_HOLD_MS) {
+                    input = HOLD;
                 }
-                break;
+            }
+            break;
+        case BUTTON_STATE_SINGLE_CLICK:
+            // timeout first: a press queued after the window starts a new click instead of being dropped
+            if (ms - handler->lastEventTime > clickTimeout) {
+                input = early ? CLICK_CONFIRMED : SINGLE_CLICK;
+                newState = pressed ? BUTTON_STATE_PRESSED : BUTTON_STATE_IDLE;
+            } else if (pressed)
+                newState = BUTTON_STATE_SINGLE_CLICK_THEN_PRESSED;
+            break;
+        case BUTTON_STATE_SINGLE_CLICK_THEN_PRESSED:
+            if (released) {
+                input = DOUBLE_CLICK;
+                newState = BUTTON_STATE_IDLE;
+            }
+            break;
+    }
+    if (handler->state != newState || input != 0)
+        handler->lastEventTime = ms;
+    handler->state = newState;
+    return input;
+}
+
+static bool updateButtons(uint8_t currentButtonState, int64_t us) {
+    // step every button with the time of the edge, not the time of the frame
+    bool clicked = false;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        bool currentState = currentButtonState & (1 << i);
+        bool lastState    = lastButtonState    & (1 << i);
+
+        ButtonDetectionHandler *handler = &buttonHandler[i];
+        if (lastState && !currentState)
+            handler->releaseTime = us;
+
+        uint8_t input = updateButton(handler, !lastState && currentState, lastState && !currentState, us / 1000);
+        handler->input |= input;
+        if (input & (SINGLE_CLICK | DOUBLE_CLICK)) {
+            // latency: releasing edge to the frame that reports the click, per click mode
+            ClickStats *stats = &inputStats.click[clickMode(handler)];
+            uint32_t latency = esp_timer_get_time() - handler->releaseTime;
+            stats->clicks++;
+            stats->latencyUs += latency;
+            if (latency > stats->maxLatencyUs)
+                stats->maxLatencyUs = latency;
+            TRACE_INSTANT("click");
+            TRACE_COUNTER("click us", latency);
+            clicked = true;
+        }
+        if (handler->releasePending) {
+            // late hold: the release ends the hold in the next frame
+            inputStats.lateHolds++;
+            TRACE_INSTANT("late hold");
+            clicked = true;
         }
-        if (handler->state != newState || handler->input != 0)
-            handler->lastEventTime = millis();
-        handler->state = newState;
+    }
+    lastButtonState = currentButtonState;
+    return clicked;
+}
+
+void updateInput() {
+    profileFrame();
+    PROFILE("input");
+    TRACE_SCOPE("input");
+    if (!inputStarted)
+        inputBegin();
+    if (!inputTimer)
+        inputSample(NULL);
+
+    for (int i = 0; i < BUTTON_COUNT; i++)
+        buttonHandler[i].input = 0;
+
+    // deferred: a release held back by a late hold is stepped at its own time, before the next edges
+    bool clicked = false;
+    for (int i = 0; i < BUTTON_COUNT && !clicked; i++) {
+        if (buttonHandler[i].releasePending)
+            clicked = updateButtons(lastButtonState, buttonHandler[i].releaseTime);
+    }
+
+    // events: queued edges in order, stop after a click so the next one is reported by the next frame
+    uint32_t head = __atomic_load_n(&inputHead, __ATOMIC_ACQUIRE);
+    while (!clicked && inputTail != head) {
+        InputEvent event = inputQueue[inputTail % INPUT_QUEUE_SIZE];
+        __atomic_store_n(&inputTail, inputTail + 1, __ATOMIC_RELEASE);
+        clicked = updateButtons(event.state, event.us);
+    }
 
+    // timeouts: hold and double click windows at the current time
+    if (!clicked)
+        updateButtons(lastButtonState, esp_timer_get_time());
+
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        ButtonDetectionHandler *handler = &buttonHandler[i];
+        if (handler->releasePending)
+            continue;
         if (handler->state == BUTTON_STATE_PRESSED || handler->state == BUTTON_STATE_HOLD || handler->state == BUTTON_STATE_SINGLE_CLICK_THEN_PRESSED)
             handler->input |= PRESSED_CONT;
     }
-    
-    lastButtonState = currentButtonState;
+    inputStats.frames++;
+}
+
+const InputStats* getInputStats() {
+    return &inputStats;
+}
+
+void inputStatsDump() {
+    static const char *modes[CLICK_MODE_COUNT] = { "single", "double", "early" };
+    printf("INPUT: %u frames, %u button edges, %u deferred samples, %u late holds\n", inputStats.frames, inputStats.events, inputStats.overflows, inputStats.lateHolds);
+    for (int i = 0; i < CLICK_MODE_COUNT; i++) {
+        ClickStats *stats = &inputStats.click[i];
+        if (stats->clicks)
+            printf("INPUT: %-6s click mode: %u clicks, %u us avg / %u us max click latency\n",
+                modes[i], stats->clicks, stats->latencyUs / stats->clicks, stats->maxLatencyUs);
+    }
 }
 
 uint8_t getInput(int bt) {
@@ -139,3 +378,471 @@ uint8_t getInput(int bt) {
         return buttonHandler[bt].input;
     return 0;
 }
+
+static bool inputBusy() {
+    // buttons held or a click pending: hold repeat and click timeouts need frames
+    if (lastButtonState)
+        return true;
+    for (int i = 0; i < BUTTON_COUNT; i++) {
+        if (buttonHandler[i].state != BUTTON_STATE_IDLE)
+            return true;
+    }
+    return false;
+}
+
+void schedulerRate(uint16_t fps, uint16_t idleFps) {
+    schedulerFps = fps;
+    schedulerIdleFps = idleFps;
+}
+
+void schedulerWake(uint32_t sources) {
+    TRACE_COUNTER("wake", sources);
+    if (schedulerTask)
+        xTaskNotify(schedulerTask, sources, eSetBits);
+}
+
+int schedulerTimer(uint32_t ms, void (*callback)(void *arg), void *arg, bool repeat) {
+    for (int i = 0; i < SCHEDULER_TIMERS; i++) {
+        SchedulerTimer *timer = &schedulerTimers[i];
+        if (timer->callback)
+            continue;
+        timer->arg = arg;
+        timer->periodMs = repeat ? ms : 0;
+        timer->due = esp_timer_get_time() + (int64_t) ms * 1000;
+        timer->callback = callback;
+        return i;
+    }
+    return -1;
+}
+
+void schedulerCancel(int timer) {
+    if (0 <= timer && timer < SCHEDULER_TIMERS)
+        schedulerTimers[timer].callback = NULL;
+}
+
+uint32_t schedulerWait() {
+    int64_t now = esp_timer_get_time();
+    if (!schedulerTask) {
+        schedulerTask = xTaskGetCurrentTaskHandle();
+        schedulerFrameStart = now;
+        return WAKE_FRAME;
+    }
+    schedulerStats.busyUs += now - schedulerFrameStart;
+
+    uint32_t wake = 0;
+    while (!wake) {
+        // timers: run on this task, the frame after them is drawn at once
+        now = esp_timer_get_time();
+        int64_t due = INT64_MAX;
+        for (int i = 0; i < SCHEDULER_TIMERS; i++) {
+            SchedulerTimer *timer = &schedulerTimers[i];
+            if (!timer->callback)
+                continue;
+            if (timer->due <= now) {
+                void (*callback)(void *arg) = timer->callback;
+                if (timer->periodMs)
+                    timer->due = now + (int64_t) timer->periodMs * 1000;
+                else
+                    timer->callback = NULL;
+                callback(timer->arg);
+                wake |= WAKE_TIMER;
+            }
+            if (timer->callback && timer->due < due)
+                due = timer->due;
+        }
+        if (wake)
+            break;
+
+        // frame: active rate after a wake event or while a button is used, idle rate otherwise -- 0 fps waits for events
+        uint16_t fps = now < schedulerActiveUntil || inputBusy() ? schedulerFps : schedulerIdleFps;
+        if (fps) {
+            int64_t frame = schedulerFrameStart + 1000000 / fps;
+            if (frame <= now) {
+                wake = WAKE_FRAME;
+                break;
+            }
+            if (frame < due)
+                due = frame;
+        }
+
+        // sleep: until the next deadline or a wake event
+        PROFILE("sleep");
+        TRACE_SCOPE("sleep");
+        uint32_t bits = 0;
+        TickType_t ticks = portMAX_DELAY;
+        if (due != INT64_MAX) {
+            ticks = pdMS_TO_TICKS((due - now + 999) / 1000);
+            if (!ticks)
+                ticks = 1;
+        }
+        xTaskNotifyWait(0, UINT32_MAX, &bits, ticks);
+        int64_t woken = esp_timer_get_time();
+        schedulerStats.sleepUs += woken - now;
+        if (bits) {
+            schedulerStats.wakes++;
+            schedulerActiveUntil = woken + SCHEDULER_ACTIVE_MS * 1000;
+            wake = bits;
+        }
+    }
+
+    schedulerFrameStart = esp_timer_get_time();
+    schedulerStats.frames++;
+    return wake;
+}
+
+const SchedulerStats* getSchedulerStats() {
+    return &schedulerStats;
+}
+
+#if PROFILER
+int profileSection(const char *name) {
+    for (int i = 0; i < profileSlots; i++) {
+        if (strcmp(profileWindow.sections[i].name, name) == 0)
+            return i;
+    }
+    if (profileSlots == PROFILE_SECTIONS)
+        return -1;
+    profileWindow.sections[profileSlots].name = name;
+    profileLast.sections[profileSlots].name = name;
+    return profileSlots++;
+}
+
+void profileAdd(int slot, uint32_t us) {
+    if (slot < 0)
+        return;
+    profileWindow.sections[slot].calls++;
+    profileWindow.sections[slot].us += us;
+}
+
+void profileFrame() {
+    int64_t now = esp_timer_get_time();
+    if (profileFrameStart) {
+        uint32_t us = now - profileFrameStart;
+        if (!profileWindow.frames || us < profileWindow.minUs)
+            profileWindow.minUs = us;
+        if (us > profileWindow.maxUs)
+            profileWindow.maxUs = us;
+        profileWindow.frames++;
+    } else {
+        profileWindowStart = profileReportStart = now;
+    }
+    profileFrameStart = now;
+
+    // window: keep the last complete window for the hud and the serial summary
+    if (now - profileWindowStart < PROFILE_WINDOW_MS * 1000)
+        return;
+    profileWindow.us = now - profileWindowStart;
+    profileLast = profileWindow;
+    profileWindow.frames = profileWindow.minUs = profileWindow.maxUs = 0;
+    for (int i = 0; i < profileSlots; i++)
+        profileWindow.sections[i].calls = profileWindow.sections[i].us = 0;
+    profileWindowStart = now;
+
+    if (PROFILE_REPORT_MS && now - profileReportStart >= PROFILE_REPORT_MS * 1000) {
+        profileReportStart = now;
+        profileDump();
+    }
+}
+
+void profileHud(bool visible) {
+    profileHudShown = visible;
+}
+
+bool profileHudVisible() {
+    return profileHudShown;
+}
+
+static int profileTop(uint32_t *shown) {
+    // largest section not shown yet
+    int top = -1;
+    for (int i = 0; i < profileSlots; i++) {
+        if (!(*shown & (1 << i)) && profileLast.sections[i].us && (top < 0 || profileLast.sections[i].us > profileLast.sections[top].us))
+            top = i;
+    }
+    if (top >= 0)
+        *shown |= 1 << top;
+    return top;
+}
+
+void profileDrawHud() {
+    if (!profileHudShown || !profileLast.frames)
+        return;
+    PROFILE("profiler");
+
+    // hud: fps and frame times on the bottom lines, then the largest sections -- fill coordinates are inclusive
+    UGUI* gui = pocuter->ugui;
+    uint16_t sizeX;
+    uint16_t sizeY;
+    pocuter->Display->getDisplaySize(sizeX, sizeY);
+    int top = sizeY - PROFILE_HUD_LINES * 8;
+    gui->UG_FillFrame(0, top, sizeX - 1, sizeY - 1, C_BLACK);
+    gui->UG_FontSelect(&FONT_POCUTER_5X7);
+    gui->UG_SetForecolor(C_YELLOW);
+
+    char line[24];
+    snprintf(line, sizeof(line), "%4.1f fps %5.1f ms", profileLast.frames * 1000000.0 / profileLast.us, profileLast.us / 1000.0 / profileLast.frames);
+    gui->UG_PutStringSingleLine(0, top, line);
+    snprintf(line, sizeof(line), "%5.1f - %5.1f ms", profileLast.minUs / 1000.0, profileLast.maxUs / 1000.0);
+    gui->UG_PutStringSingleLine(0, top + 8, line);
+
+    gui->UG_SetForecolor(C_WHITE);
+    uint32_t shown = 0;
+    for (int i = 2; i < PROFILE_HUD_LINES; i++) {
+        int slot = profileTop(&shown);
+        if (slot < 0)
+            break;
+        snprintf(line, sizeof(line), "%-8.8s %5.1f%%", profileLast.sections[slot].name, 100.0 * profileLast.sections[slot].us / profileLast.us);
+        gui->UG_PutStringSingleLine(0, top + i * 8, line);
+    }
+}
+
+void profileDump() {
+    if (!profileLast.frames)
+        return;
+    PROFILE("profiler");
+    printf("PROFILE: %0.1f fps, frame %0.2f ms avg, %0.2f ms min, %0.2f ms max\n",
+        profileLast.frames * 1000000.0 / profileLast.us, profileLast.us / 1000.0 / profileLast.frames,
+        profileLast.minUs / 1000.0, profileLast.maxUs / 1000.0);
+
+    // sections: largest first, the rest of the frame is app code outside of any section
+    uint32_t shown = 0;
+    uint32_t other = profileLast.us;
+    for (int slot = profileTop(&shown); slot >= 0; slot = profileTop(&shown)) {
+        ProfileSection *section = &profileLast.sections[slot];
+        printf("PROFILE:   %-10s %7.2f ms/frame %5.1f%% %6u calls\n", section->name,
+            section->us / 1000.0 / profileLast.frames, 100.0 * section->us / profileLast.us, section->calls);
+        other = section->us < other ? other - section->us : 0;
+    }
+    printf("PROFILE:   %-10s %7.2f ms/frame %5.1f%%\n", "(other)", other / 1000.0 / profileLast.frames, 100.0 * other / profileLast.us);
+}
+
+const ProfileStats* getProfileStats() {
+    return &profileLast;
+}
+#else
+int profileSection(const char *name) { return -1; }
+void profileAdd(int slot, uint32_t us) {}
+void profileFrame() {}
+void profileHud(bool visible) {}
+bool profileHudVisible() { return false; }
+void profileDrawHud() {}
+void profileDump() {}
+const ProfileStats* getProfileStats() { return NULL; }
+#endif
+
+#if TRACE
+int traceName(const char *name) {
+    // slots are claimed without a lock, the first marker of a name may run on any task
+    for (int i = 0; i < TRACE_NAMES; i++) {
+        const char *known = __atomic_load_n(&traceNames[i], __ATOMIC_ACQUIRE);
+        if (!known && __atomic_compare_exchange_n(&traceNames[i], &known, name, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            return i;
+        if (strcmp(known, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static uint8_t traceTask() {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < TRACE_TASKS; i++) {
+        TaskHandle_t known = __atomic_load_n(&traceTasks[i], __ATOMIC_ACQUIRE);
+        if (!known && __atomic_compare_exchange_n(&traceTasks[i], &known, task, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            strncpy(traceTaskNames[i], pcTaskGetName(NULL), TRACE_TASK_NAME - 1);
+            return i;
+        }
+        if (known == task)
+            return i;
+    }
+    return TRACE_TASKS;
+}
+
+void traceRecord(uint8_t type, int name, int32_t value) {
+    if (name < 0 || !traceEnabled)
+        return;
+
+    // claim: the slot of the oldest event, no locks and no allocation
+    uint32_t index = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED);
+    uint32_t slot = index % TRACE_EVENTS;
+    __atomic_store_n(&traceSeq[slot], 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    TraceEvent *event = &traceEvents[slot];
+    event->us = esp_timer_get_time();
+    event->value = value;
+    event->type = type;
+    event->name = name;
+    event->task = traceTask();
+
+    // publish: readers only take the event once its sequence matches the claim
+    __atomic_store_n(&traceSeq[slot], index + 1, __ATOMIC_RELEASE);
+}
+
+static bool traceRead(uint32_t index, TraceEvent *dest) {
+    // skip: a slot still being written, or already claimed again by a newer event
+    uint32_t slot = index % TRACE_EVENTS;
+    if (__atomic_load_n(&traceSeq[slot], __ATOMIC_ACQUIRE) != index + 1)
+        return false;
+    *dest = traceEvents[slot];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&traceSeq[slot], __ATOMIC_RELAXED) == index + 1;
+}
+
+void traceEnable(bool enabled) {
+    traceEnabled = enabled;
+}
+
+uint32_t traceSnapshot(TraceEvent *dest) {
+    // pause: events recorded while copying would overwrite the oldest ones
+    bool enabled = traceEnabled;
+    traceEnabled = false;
+    uint32_t head = __atomic_load_n(&traceHead, __ATOMIC_ACQUIRE);
+    uint32_t count = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+    uint32_t copied = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (traceRead(head - count + i, &dest[copied]))
+            copied++;
+    }
+    traceEnabled = enabled;
+    return copied;
+}
+
+static size_t traceFormatEvent(const TraceEvent *event, char *dest, size_t maxLength) {
+    return snprintf(dest, maxLength, "E %u %c %u %u %d\n", event->us, event->type, event->name, event->task, event->value);
+}
+
+size_t traceFormat(const TraceEvent *events, uint32_t count, uint32_t *cursor, char *dest, size_t maxLength) {
+    // lines: header, names, tasks, then the events -- unused slots are skipped
+    while (true) {
+        uint32_t line = (*cursor)++;
+        if (line == 0)
+            return snprintf(dest, maxLength, "# pocuter trace v1\n");
+        line -= 1;
+        if (line < TRACE_NAMES) {
+            const char *name = __atomic_load_n(&traceNames[line], __ATOMIC_ACQUIRE);
+            if (name)
+                return snprintf(dest, maxLength, "N %u %s\n", line, name);
+            continue;
+        }
+        line -= TRACE_NAMES;
+        if (line < TRACE_TASKS) {
+            if (traceTaskNames[line][0])
+                return snprintf(dest, maxLength, "T %u %s\n", line, traceTaskNames[line]);
+            continue;
+        }
+        line -= TRACE_TASKS;
+        if (line < count)
+            return traceFormatEvent(&events[line], dest, maxLength);
+        (*cursor)--;
+        return 0;
+    }
+}
+
+void traceDump() {
+    // serial: formatted straight from the ring, recording is paused while printing
+    bool enabled = traceEnabled;
+    traceEnabled = false;
+    char line[TRACE_LINE];
+    uint32_t cursor = 0;
+    while (traceFormat(NULL, 0, &cursor, line, sizeof(line)))
+        printf("TRACE: %s", line);
+
+    uint32_t head = __atomic_load_n(&traceHead, __ATOMIC_ACQUIRE);
+    uint32_t count = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+    uint32_t skipped = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        TraceEvent event;
+        if (!traceRead(head - count + i, &event)) {
+            skipped++;
+            continue;
+        }
+        traceFormatEvent(&event, line, sizeof(line));
+        printf("TRACE: %s", line);
+    }
+    printf("TRACE: # %u events, %u overwritten, %u incomplete\n", count - skipped, head - count, skipped);
+    traceEnabled = enabled;
+}
+#else
+int traceName(const char *name) { return -1; }
+void traceRecord(uint8_t type, int name, int32_t value) {}
+void traceEnable(bool enabled) {}
+uint32_t traceSnapshot(TraceEvent *dest) { return 0; }
+size_t traceFormat(const TraceEvent *events, uint32_t count, uint32_t *cursor, char *dest, size_t maxLength) { return 0; }
+void traceDump() {}
+#endif
+
+static int64_t bootPhaseWallClock() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+void bootPhase(const char *name) {
+    BootPhaseLog *log = &bootPhaseLog[0];
+
+    // first phase of this boot: keep the log of the previous boot, start a new one
+    if (!bootPhaseStarted) {
+        bootPhaseStarted = true;
+        if (log->magic == BOOT_PHASE_MAGIC && log->count <= BOOT_PHASE_MAX)
+            bootPhaseLog[1] = *log;
+        else
+            bootPhaseLog[1].magic = 0;
+        log->magic = BOOT_PHASE_MAGIC;
+        log->count = 0;
+        log->dumped = 0;
+    }
+
+    if (log->count >= BOOT_PHASE_MAX)
+        return;
+
+    BootPhase *phase = &log->phases[log->count];
+    strncpy(phase->name, name, BOOT_PHASE_NAME - 1);
+    phase->name[BOOT_PHASE_NAME - 1] = '\0';
+    phase->us = micros();
+    phase->wall = bootPhaseWallClock();
+    log->count++;
+}
+
+void bootPhaseDump() {
+    BootPhaseLog *log = &bootPhaseLog[0];
+    if (!bootPhaseStarted || log->dumped == log->count)
+        return;
+
+    // print the phases recorded by the previous boot before the restart
+    if (log->dumped == 0 && bootPhaseLog[1].magic == BOOT_PHASE_MAGIC && bootPhaseLog[1].count) {
+        BootPhaseLog *prev = &bootPhaseLog[1];
+        BootPhase *last = &prev->phases[prev->count - 1];
+        printf("BOOT: previous boot ended at '%s' %10.6f s, restart took %0.6f s\n",
+            last->name, last->us / 1000000.0, getBootPhaseGap() / 1000000.0);
+    }
+
+    // print the phases recorded since the last dump
+    for (int i = log->dumped; i < log->count; i++) {
+        BootPhase *phase = &log->phases[i];
+        uint32_t delta = i ? phase->us - log->phases[i - 1].us : phase->us;
+        printf("BOOT: %-12s %10.6f s  (+%0.6f s)\n", phase->name, phase->us / 1000000.0, delta / 1000000.0);
+    }
+    log->dumped = log->count;
+}
+
+int bootPhaseCount() {
+    return bootPhaseStarted ? bootPhaseLog[0].count : 0;
+}
+
+bool getBootPhase(int index, const char **name, uint32_t *us) {
+    if (index < 0 || index >= bootPhaseCount())
+        return false;
+    *name = bootPhaseLog[0].phases[index].name;
+    *us = bootPhaseLog[0].phases[index].us;
+    return true;
+}
+
+int64_t getBootPhaseGap() {
+    BootPhaseLog *prev = &bootPhaseLog[1];
+    if (!bootPhaseStarted || prev->magic != BOOT_PHASE_MAGIC || !prev->count)
+        return 0;
+
+    // wall clock time between the last phase of the previous boot and the first phase of this boot
+    int64_t gap = bootPhaseLog[0].phases[0].wall - prev->phases[prev->count - 1].wall;
+    return gap > 0 ? gap : 0;
+}
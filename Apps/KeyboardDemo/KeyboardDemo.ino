@@ -13,6 +13,9 @@ PocuterUtil::Keyboard *keyboard_color;
 PocuterUtil::Keyboard *keyboard_text;
 PocuterUtil::Keyboard *keyboard_ip;
 
+// word completion dictionary for the text keyboard, created with Libs/Keyboard/tools/build-dict
+PocuterUtil::KeyboardDict *dictionary;
+
 // initialize color swatch for color code 'smart' keyboard
 UG_COLOR keyboard_color_swatch = C_BLACK;
 char keyboard_color_string[7];
@@ -20,6 +23,16 @@ char keyboard_color_string[7];
 // buffers for last entered keyboard text
 char display_text[32 + 2 + 1];
 
+// print keyboard draw statistics to the serial console
+void printKeyboardStats( const char *name, PocuterUtil::Keyboard *keyboard ) {
+	PocuterUtil::KeyboardStats &stats = keyboard->stats;
+	printf("%s keyboard: %u frames, %u redrawn, %u pixels/frame, %u us/frame\n", name,
+		stats.frames, stats.draws,
+		stats.frames ? stats.pixels / stats.frames : 0,
+		stats.frames ? stats.micros / stats.frames : 0 );
+	inputStatsDump();
+}
+
 void setup() {
 	pocuter = new Pocuter();
 	pocuter->begin(PocuterDisplay::BUFFER_MODE_DOUBLE_BUFFER);
@@ -40,17 +53,30 @@ void setup() {
 	// create a 'smart' keyboard for entering a six digit hex color code
 	// disable autoupdate to allow for flicker free display post-processing
 	// see the post-processing block for example of real-time keyboard input processing + formatting
-	keyboard_color = new PocuterUtil::Keyboard( pocuter, (char*)"Enter color code", KEYSET_HEX, 6 );
+	// the key set and length are template arguments, the text buffer is part of the object
+	keyboard_color = new PocuterUtil::KeyboardT<KEYSET_HEX, 6>( pocuter, (char*)"Enter color code" );
 	keyboard_color->autoupdate = false;
 	
 	// create a keyboard for entering full text with space char, limit length to 32 characters + set default text
 	keyboard_text = new PocuterUtil::Keyboard( pocuter, (char*)"Enter text", KEYSET_FULL, 32 );
 	keyboard_text->set( (char*)"Hello World!" );
 	
+	// enable the editing mode -- the cursor keys move through the text to fix a typo without deleting the rest
+	keyboard_text->edit();
+	
+	// offer word completions from a dictionary on the sd card -- the keyboard works without the file
+	char dictionary_path[64];
+	snprintf( dictionary_path, sizeof(dictionary_path), "%s/dict/english.pkd", pocuter->SDCard->getMountPoint() );
+	dictionary = new PocuterUtil::KeyboardDict( dictionary_path );
+	keyboard_text->complete( dictionary, false );
+	
 	// create a keyboard for entering an ip address and bind it to a configuration setting
 	keyboard_ip = new PocuterUtil::Keyboard( pocuter, (char*)"Enter ip address", KEYSET_IPADDR );
 	keyboard_ip->bind( (char*)"keyboard", (char*)"ip-address", true );
 	
+	// offer the most recently saved ip addresses as completions
+	keyboard_ip->complete( NULL, true );
+	
 	// initialize result display text
 	strcpy( display_text, "> ");
 	
@@ -76,9 +102,8 @@ void loop() {
 	uint16_t sizeY;
 	pocuter->Display->getDisplaySize(sizeX, sizeY);
 	
-	// clear screen
+	// select font -- the screen is cleared by the idle screen, keyboards only redraw what changed
 	UGUI* gui = pocuter->ugui;	
-	gui->UG_FillFrame(0, 0, sizeX, sizeY, C_BLACK);
 	gui->UG_FontSelect(&FONT_POCUTER_5X7);
 	gui->UG_SetForecolor( pocuterSettings.systemColor );
 	
@@ -95,6 +120,9 @@ void loop() {
 	// no active keyboards -- display usage text, last entry result, test button inputs
 	if( !(keyboard_color->active || keyboard_text->active || keyboard_ip->active) ) {
 		
+		// clear screen
+		gui->UG_FillFrame(0, 0, sizeX, sizeY, C_BLACK);
+		
 		// display application label
 		gui->UG_SetForecolor( pocuterSettings.systemColor | 0x00808080 );
 		gui->UG_PutStringSingleLine(0, 0, "Keyboard Demo" );
@@ -127,6 +155,7 @@ void loop() {
 		if( keyboard_text->getchar() ) {
 			if( !keyboard_text->active ) {
 				strcpy( &display_text[2], keyboard_text->get() );
+				printKeyboardStats( "text", keyboard_text );
 			}
 		}
 		return;
@@ -138,6 +167,7 @@ void loop() {
 			if( !keyboard_ip->active ) {
 				strcpy( &display_text[2], keyboard_text->get() );
 				keyboard_ip->save();
+				printKeyboardStats( "ip", keyboard_ip );
 			}
 		}
 		return;
@@ -149,9 +179,11 @@ void loop() {
 		// display keyboard + process input
 		bool changed = keyboard_color->getchar();
 		
-		// display color swatch overlay + update screen
-		gui->UG_FillFrame(sizeX - 16, (sizeY/2)-7, sizeX, (sizeY/2)+8, keyboard_color_swatch);
-		pocuter->Display->updateScreen();
+		// display color swatch overlay + update screen when the keyboard was redrawn or the color changed
+		if( keyboard_color->updated || changed ) {
+			gui->UG_FillFrame(sizeX - 16, (sizeY/2)-7, sizeX, (sizeY/2)+8, keyboard_color_swatch);
+			pocuter->Display->updateScreen();
+		}
 		
 		if( changed ) {
 			// input complete -- copy string buffers
@@ -162,6 +194,7 @@ void loop() {
 				
 				// copy keyboard text to display buffer
 				strcpy( &display_text[2], keyboard_color->get() );
+				printKeyboardStats( "color", keyboard_color );
 			}
 			
 			// input changed -- update color swatch variable
@@ -0,0 +1 @@
+/home/nsystems/Projects/Pocuter/Development/PocuterUtils/Libs/Keyboard/KeyboardDict.h
\ No newline at end of file
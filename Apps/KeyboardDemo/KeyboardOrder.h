@@ -0,0 +1 @@
+/home/nsystems/Projects/Pocuter/Development/PocuterUtils/Libs/Keyboard/KeyboardOrder.h
\ No newline at end of file
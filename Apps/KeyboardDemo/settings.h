@@ -10,6 +10,14 @@
 // MACROS
 // ========================================
 
+#define SETTINGS_CACHE          1       // serve settings from memory and write changes delayed, 0: access the file on every call
+#define SETTINGS_FLUSH_DELAY    2000    // ms without changes before changed settings are written
+#define SETTINGS_VALUE_MAX      256     // setting value buffer including the terminator, longer values are rejected by set calls
+#define SETTINGS_TASK_STACK     4096    // flush task stack, KVStore::put() holds a 1 KiB value on the stack
+#define SETTINGS_TASK_PRIORITY  1
+#define SETTINGS_FILE           "settings"
+#define SETTINGS_KVSTORE        0       // 1: store settings in a key-value log next to the app (Libs/KVStore), ini values are migrated on first read
+
 // ========================================
 // TYPES
 // ========================================
@@ -19,6 +27,17 @@ struct PocuterSettings {
     int brightness;
 };
 
+struct SettingsStats {
+    uint32_t reads;         // get calls
+    uint32_t fileReads;     // values read from the config file
+    uint32_t writes;        // set calls
+    uint32_t fileWrites;    // values written to the config file
+    uint32_t readUs;        // time spent in get calls
+    uint32_t writeUs;       // time spent in set calls and flushes
+    uint32_t dirty;         // cached values changed but not written yet
+    uint32_t failedWrites;  // values a flush failed to write, they stay changed for the next flush
+};
+
 // ========================================
 // PROTOTYPES
 // ========================================
@@ -29,11 +48,18 @@ extern int      getSetting(const char *section, const char *name, int defaultVal
 extern uint32_t getSetting(const char *section, const char *name, uint32_t defaultValue);
 extern double   getSetting(const char *section, const char *name, double defaultValue);
 
-extern bool     setSetting(const char *section, const char *name, char *value);
+extern bool     setSetting(const char *section, const char *name, const char *value);
 extern bool     setSetting(const char *section, const char *name, int value);
 extern bool     setSetting(const char *section, const char *name, uint32_t value);
 extern bool     setSetting(const char *section, const char *name, double value);
 
+extern bool     getConfigSetting(const char *file, const char *section, const char *name, char *dest, size_t maxLength);
+// set: with SETTINGS_CACHE true once the value is cached, the file is written later by the flush task --
+// write errors are reported by flushSettings(), the flush task logs them and keeps the values for the next flush
+extern bool     setConfigSetting(const char *file, const char *section, const char *name, const char *value);
+extern bool     flushSettings();
+extern const SettingsStats* getSettingsStats();
+
 // ========================================
 // GLOBALS
 // ========================================
@@ -6,6 +6,7 @@
 
 #include <Pocuter.h>
 #include <Arduino.h>
+#include <esp_timer.h>
 
 // ========================================
 // MACROS
@@ -15,6 +16,8 @@
 #define DOUBLE_CLICK    0x2
 #define HOLD            0x4
 #define PRESSED_CONT    0x8
+#define CLICK_PROVISIONAL   0x10    // early click: single click reported at release, a DOUBLE_CLICK may still follow
+#define CLICK_CONFIRMED     0x20    // early click: no second click followed the provisional single click
 
 #define BUTTON_A            0
 #define BUTTON_B            1
@@ -28,18 +31,165 @@
 #define ACTION_DOUBLE_CLICK_C   (getInput(BUTTON_C) & DOUBLE_CLICK)
 #define ACTION_BACK_TO_MENU    ((getInput(1) & PRESSED_CONT) && (getInput(2) & PRESSED_CONT))
 
+#define WAKE_FRAME      0x01    // frame deadline
+#define WAKE_TIMER      0x02    // scheduler timer callback ran
+#define WAKE_BUTTON     0x04    // button edge
+#define WAKE_NETWORK    0x08    // network activity
+#define WAKE_SDCARD     0x10    // sd card event
+
+#define BOOT_PHASE_MAX      16
+#define BOOT_PHASE_NAME     12
+
+// profiler: off unless the build enables it, for example with -DPROFILER=1 -DPROFILE_REPORT_MS=5000
+#ifndef PROFILER
+#define PROFILER            0       // 1: compile the frame profiler, 0: PROFILE() markers compile to nothing
+#endif
+#define PROFILE_SECTIONS    8       // named sections, markers of further names are ignored
+#define PROFILE_WINDOW_MS   1000    // frame statistics window shown by the hud
+#ifndef PROFILE_REPORT_MS
+#define PROFILE_REPORT_MS   0       // serial summary period, 0: no summaries
+#endif
+
+#if PROFILER
+#define PROFILE_CONCAT_(a, b)   a##b
+#define PROFILE_CONCAT(a, b)    PROFILE_CONCAT_(a, b)
+#define PROFILE(name) \
+    static int PROFILE_CONCAT(profileSlot, __LINE__) = profileSection(name); \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileSlot, __LINE__))
+#else
+#define PROFILE(name)
+#endif
+
+// trace: off unless the build enables it with -DTRACE=1 -- the event ring takes about 8 KiB of static ram
+#ifndef TRACE
+#define TRACE               0       // 1: compile the trace recorder, 0: TRACE_*() markers compile to nothing
+#endif
+#define TRACE_EVENTS        512     // events kept, power of two -- the oldest events are overwritten
+#define TRACE_NAMES         32      // event names, markers of further names are ignored
+#define TRACE_TASKS         8       // tasks told apart, events of further tasks are recorded as task TRACE_TASKS
+
+#define TRACE_TYPE_BEGIN    'B'
+#define TRACE_TYPE_END      'E'
+#define TRACE_TYPE_INSTANT  'I'
+#define TRACE_TYPE_COUNTER  'C'
+
+#if TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+#define TRACE_EVENT(type, name, value) \
+    do { static int traceSlot = traceName(name); traceRecord(type, traceSlot, value); } while (0)
+#define TRACE_BEGIN(name)           TRACE_EVENT(TRACE_TYPE_BEGIN, name, 0)
+#define TRACE_END(name)             TRACE_EVENT(TRACE_TYPE_END, name, 0)
+#define TRACE_INSTANT(name)         TRACE_EVENT(TRACE_TYPE_INSTANT, name, 0)
+#define TRACE_COUNTER(name, value)  TRACE_EVENT(TRACE_TYPE_COUNTER, name, value)
+#define TRACE_SCOPE(name) \
+    static int TRACE_CONCAT(traceSlot, __LINE__) = traceName(name); \
+    TraceScope TRACE_CONCAT(traceScope, __LINE__)(TRACE_CONCAT(traceSlot, __LINE__))
+#else
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_INSTANT(name)
+#define TRACE_COUNTER(name, value)
+#define TRACE_SCOPE(name)
+#endif
+
 // ========================================
 // TYPES
 // ========================================
 
+enum ClickMode {
+    CLICK_MODE_SINGLE,      // double click disabled: single click at release
+    CLICK_MODE_DOUBLE,      // double click enabled: single click after the click timeout
+    CLICK_MODE_EARLY,       // double click and early click enabled: provisional single click at release
+    CLICK_MODE_COUNT
+};
+
+struct ClickStats {
+    uint32_t clicks;        // single and double clicks reported
+    uint32_t latencyUs;     // total time from the releasing edge to the reporting updateInput call
+    uint32_t maxLatencyUs;
+};
+
+struct InputStats {
+    uint32_t frames;        // updateInput calls
+    uint32_t events;        // button edges sampled by the input timer
+    uint32_t overflows;     // samples deferred because the event queue was full
+    uint32_t lateHolds;     // holds found at a release stepped after the hold timeout, reported before the release
+    ClickStats click[CLICK_MODE_COUNT];
+};
+
+struct ProfileSection {
+    const char *name;
+    uint32_t calls;
+    uint32_t us;
+};
+
+struct ProfileStats {
+    uint32_t frames;        // frames completed in the window
+    uint32_t us;            // window length
+    uint32_t minUs;         // frame time
+    uint32_t maxUs;
+    ProfileSection sections[PROFILE_SECTIONS];
+};
+
+struct TraceEvent {
+    uint32_t us;            // esp_timer time, low 32 bits -- wraps after 71 minutes
+    int32_t value;          // counter value
+    uint8_t type;           // TRACE_TYPE_*
+    uint8_t name;           // traceName() slot
+    uint8_t task;           // task slot, TRACE_TASKS: unknown task
+    uint8_t reserved;
+};
+
+struct SchedulerStats {
+    uint32_t frames;        // schedulerWait calls
+    uint32_t wakes;         // frames started early by a wake event
+    uint64_t sleepUs;       // time the loop() task slept in schedulerWait
+    uint64_t busyUs;        // time spent between schedulerWait calls
+};
+
 // ========================================
 // PROTOTYPES
 // ========================================
 
+extern int  profileSection(const char *name);
+extern void profileAdd(int slot, uint32_t us);
+extern void profileFrame();
+extern void profileHud(bool visible);
+extern bool profileHudVisible();
+extern void profileDrawHud();
+extern void profileDump();
+extern const ProfileStats* getProfileStats();
+
+extern int      traceName(const char *name);
+extern void     traceRecord(uint8_t type, int name, int32_t value);
+extern void     traceEnable(bool enabled);
+extern uint32_t traceSnapshot(TraceEvent *dest);
+extern size_t   traceFormat(const TraceEvent *events, uint32_t count, uint32_t *cursor, char *dest, size_t maxLength);
+extern void     traceDump();
+
 extern void enableDoubleClick(int bt);
 extern void disableDoubleClick(int bt);
+extern void enableEarlyClick(int bt);
+extern void disableEarlyClick(int bt);
+extern void setClickTimeout(int bt, uint16_t clickMs, uint16_t holdMs = 0);
 extern void updateInput();
 extern uint8_t getInput(int bt);
+extern const InputStats* getInputStats();
+extern void inputStatsDump();
+
+extern void     schedulerRate(uint16_t fps, uint16_t idleFps);
+extern uint32_t schedulerWait();
+extern void     schedulerWake(uint32_t sources);
+extern int      schedulerTimer(uint32_t ms, void (*callback)(void *arg), void *arg, bool repeat = false);
+extern void     schedulerCancel(int timer);
+extern const SchedulerStats* getSchedulerStats();
+
+extern void bootPhase(const char *name);
+extern void bootPhaseDump();
+extern int  bootPhaseCount();
+extern bool getBootPhase(int index, const char **name, uint32_t *us);
+extern int64_t getBootPhaseGap();
 
 // ========================================
 // GLOBALS
@@ -52,6 +202,25 @@ extern double dt;
 // FUNCTIONS
 // ========================================
 
+#if PROFILER
+// scoped section marker -- adds the time until the end of the scope to the section, use PROFILE(name)
+struct ProfileScope {
+    int slot;
+    int64_t start;
+    ProfileScope(int slot) : slot(slot), start(esp_timer_get_time()) {}
+    ~ProfileScope() { profileAdd(slot, esp_timer_get_time() - start); }
+};
+#endif
+
+#if TRACE
+// scoped trace marker -- records a begin event now and the end event at the end of the scope, use TRACE_SCOPE(name)
+struct TraceScope {
+    int slot;
+    TraceScope(int slot) : slot(slot) { traceRecord(TRACE_TYPE_BEGIN, slot, 0); }
+    ~TraceScope() { traceRecord(TRACE_TYPE_END, slot, 0); }
+};
+#endif
+
 
 
 #endif //_SYSTEM_H_
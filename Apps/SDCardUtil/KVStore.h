@@ -0,0 +1 @@
+/home/nsystems/Projects/Pocuter/Development/PocuterUtils/Libs/KVStore/KVStore.h
\ No newline at end of file
@@ -3,9 +3,20 @@
 #include <Pocuter.h>
 #include "settings.h"
 #include "system.h"
+#include "sdbench.h"
+#include "sdservice.h"
 
 long lastFrame;
 
+// card service: result line of the last mount/unmount operation
+char card_status[24] = "";
+bool force_unmount = false;
+
+// screens: mount state, running benchmark, benchmark results (one page per test)
+enum AppScreen { SCREEN_MOUNT, SCREEN_BENCH, SCREEN_RESULTS };
+AppScreen screen = SCREEN_MOUNT;
+int result_page = 0;
+
 void setup() {
     pocuter = new Pocuter();
     pocuter->begin(PocuterDisplay::BUFFER_MODE_DOUBLE_BUFFER);
@@ -20,8 +31,15 @@ void setup() {
     enableDoubleClick(BUTTON_B);
     enableDoubleClick(BUTTON_C);
 
+    // A/B page through the results at once -- C keeps the delayed single click, it starts the benchmark
+    enableEarlyClick(BUTTON_A);
+    enableEarlyClick(BUTTON_B);
+
     // setup your app here
     lastFrame = micros();
+
+    // card: detection and mount/unmount run in the background -- mounting stays manual
+    sdServiceBegin(false);
 }
 
 void loop() {
@@ -30,6 +48,7 @@ void loop() {
     updateInput();
 
     if (ACTION_BACK_TO_MENU) {
+        inputStatsDump();
         pocuter->OTA->setNextAppID(1);
         pocuter->OTA->restart();
     }
@@ -44,12 +63,101 @@ void loop() {
     gui->UG_FillFrame(0, 0, sizeX, 11, C_RED);
     gui->UG_FontSelect(&FONT_POCUTER_5X7);
 
+    // card: apply events posted by the card service -- a removed card ends the benchmark, its files are closed
+    // before the service drops the mount
+    SDServiceEvent event;
+    while( sdServiceGetEvent(&event) ) {
+        if( event.type == SDSERVICE_EVENT_REMOVED )
+            sdBenchAbort("CARD REMOVED");
+        force_unmount = event.type == SDSERVICE_EVENT_FILES_OPEN;
+        if( event.type == SDSERVICE_EVENT_FILES_OPEN ) {
+            snprintf(card_status, sizeof(card_status), "%d FILES OPEN", event.openFiles);
+        } else if( event.us ) {
+            snprintf(card_status, sizeof(card_status), "%s %ums", sdServiceEventName(event.type), event.us / 1000);
+        } else {
+            snprintf(card_status, sizeof(card_status), "%s", sdServiceEventName(event.type));
+        }
+    }
+
+    // benchmark: run one time slice per frame and show progress
+    if( screen == SCREEN_BENCH ) {
+        gui->UG_SetForecolor( C_YELLOW );
+        gui->UG_PutStringSingleLine(0, 8*0, "SD BENCHMARK");
+
+        if( !sdBenchStep() ) {
+            screen = SCREEN_RESULTS;
+            result_page = 0;
+        }
+
+        int pct = sdBenchProgress();
+        gui->UG_SetForecolor( C_PLUM);
+        gui->UG_PutStringSingleLine(0, 8*2, sdBenchStatus());
+        gui->UG_FillFrame(0, 8*4, sizeX - 1, 8*4 + 8, C_WHITE);
+        gui->UG_FillFrame(1, 8*4 + 1, sizeX - 2, 8*4 + 7, C_BLACK);
+        gui->UG_FillFrame(2, 8*4 + 2, 2 + (sizeX - 5) * pct / 100, 8*4 + 6, C_WHITE);
+
+        pocuter->Display->updateScreen();
+        return;
+    }
+
+    // results: one page per test, A/B change page, C returns
+    if( screen == SCREEN_RESULTS ) {
+        const SDBenchResult* result = sdBenchResult(result_page);
+        char line[24];
+
+        gui->UG_SetForecolor( C_YELLOW );
+        gui->UG_PutStringSingleLine(0, 8*0, result->name);
+
+        gui->UG_SetForecolor( C_PLUM);
+        if( strcmp(sdBenchStatus(), "DONE") != 0 ) {
+            gui->UG_PutStringSingleLine(0, 8*1, sdBenchStatus());
+        }
+        if( result->ops ) {
+            if( result_page >= SDBENCH_INI_SET )
+                snprintf(line, sizeof(line), "B/op %9llu", result->bytes / result->ops);
+            else
+                snprintf(line, sizeof(line), "MB/s %9.3f", sdBenchMBps(result));
+            gui->UG_PutStringSingleLine(0, 8*2, line);
+            snprintf(line, sizeof(line), "IOPS %9.1f", sdBenchIOPS(result));
+            gui->UG_PutStringSingleLine(0, 8*3, line);
+            snprintf(line, sizeof(line), "p50 %7.2f ms", result->p50 / 1000.0);
+            gui->UG_PutStringSingleLine(0, 8*4, line);
+            snprintf(line, sizeof(line), "p99 %7.2f ms", result->p99 / 1000.0);
+            gui->UG_PutStringSingleLine(0, 8*5, line);
+            snprintf(line, sizeof(line), "max %7.2f ms", result->max / 1000.0);
+            gui->UG_PutStringSingleLine(0, 8*6, line);
+        }
+
+        gui->UG_SetForecolor( C_WHITE );
+        snprintf(line, sizeof(line), "%d/%d A/B C:EXIT", result_page + 1, SDBENCH_TEST_COUNT);
+        gui->UG_PutStringSingleLine(0, 8*7, line);
+
+        // early click: the second click of a double click turns one more page
+        if( ACTION_SINGLE_CLICK_A || ACTION_DOUBLE_CLICK_A ) result_page = (result_page + SDBENCH_TEST_COUNT - 1) % SDBENCH_TEST_COUNT;
+        if( ACTION_SINGLE_CLICK_B || ACTION_DOUBLE_CLICK_B ) result_page = (result_page + 1) % SDBENCH_TEST_COUNT;
+        if( ACTION_SINGLE_CLICK_C ) screen = SCREEN_MOUNT;
+
+        pocuter->Display->updateScreen();
+        return;
+    }
+
     // get sdcard mount state
-    bool is_mounted = pocuter->SDCard->cardIsMounted();
-    bool is_card = pocuter->SDCard->cardInSlot();
+    SDServiceState card_state = sdServiceState();
+    bool is_mounted = card_state == SDSERVICE_MOUNTED;
+    bool is_card = card_state != SDSERVICE_NO_CARD;
 
     // display sd card mount state
-    if( is_mounted ) {
+    if( card_state == SDSERVICE_MOUNTING || card_state == SDSERVICE_UNMOUNTING ) {
+        // operation running on the card service task -- show elapsed time
+        char elapsed[24];
+        snprintf(elapsed, sizeof(elapsed), "%0.2f s", sdServiceElapsed() / 1000000.0);
+
+        gui->UG_SetForecolor( C_YELLOW );
+        gui->UG_PutStringSingleLine(0, 8*0, card_state == SDSERVICE_MOUNTING ? "MOUNTING..." : "UNMOUNTING...");
+
+        gui->UG_SetForecolor( C_PLUM);
+        gui->UG_PutStringSingleLine(0, 8*2, elapsed);
+    } else if( is_mounted ) {
         gui->UG_SetForecolor( C_YELLOW );
         gui->UG_PutStringSingleLine(0, 8*0, "CARD IS MOUNTED");
 
@@ -57,6 +165,10 @@ void loop() {
         gui->UG_PutStringSingleLine(0, 8*2, "Unmount card by");
         gui->UG_PutStringSingleLine(0, 8*3, "double clicking");
         gui->UG_PutStringSingleLine(0, 8*4, "any button");
+
+        gui->UG_SetForecolor( C_WHITE );
+        gui->UG_PutStringSingleLine(0, 8*6, "Click C to run");
+        gui->UG_PutStringSingleLine(0, 8*7, "card benchmark");
     } else {
         if( is_card ) {
             // umounted card available for mounting
@@ -74,16 +186,31 @@ void loop() {
         }
     }
 
-    // mount or unmount card as a response to button double click
+    // display result of the last card operation
+    gui->UG_SetForecolor( C_WHITE );
+    gui->UG_PutStringSingleLine(0, 8*5, card_status);
+
+    // benchmark: start on single click while mounted
+    if( is_mounted && ACTION_SINGLE_CLICK_C ) {
+        if( sdBenchStart(pocuter->SDCard->getMountPoint()) ) {
+            screen = SCREEN_BENCH;
+        } else {
+            screen = SCREEN_RESULTS;
+            result_page = 0;
+        }
+    }
+
+    // mount or unmount card as a response to button double click -- a second double click forces
+    // the unmount when the first one reported open files
     if( ACTION_DOUBLE_CLICK_A || ACTION_DOUBLE_CLICK_B || ACTION_DOUBLE_CLICK_C ) {        
-        const char* mount_point = pocuter->SDCard->getMountPoint();
         if( is_mounted ) {
             printf("--> unmount card!\n");
-            pocuter->SDCard->unmount();
-        } else {
+            sdServiceUnmount(force_unmount);
+        } else if( is_card ) {
             printf("<-- mount card!\n");
-            pocuter->SDCard->mount();
+            sdServiceMount();
         }
+        force_unmount = false;
     }
 
     // update display
@@ -0,0 +1,480 @@
+// ========================================
+// INCLUDES
+// ========================================
+
+#include "sdbench.h"
+#include "system.h"
+#include "sdservice.h"
+#include <esp_timer.h>
+#include <ff.h>
+#include "KVStore.h"
+
+// ========================================
+// MACROS
+// ========================================
+
+#define SDBENCH_SEQ_OPS         (SDBENCH_SEQ_SIZE / SDBENCH_SEQ_BLOCK)
+#define SDBENCH_RAND_SLOTS      (SDBENCH_SEQ_SIZE / SDBENCH_RAND_BLOCK)
+#define SDBENCH_SETTING_FILE    "sdbench"       // ini settings file of the INI tests
+#define SDBENCH_SETTING_SECTION "bench"
+
+#if FF_MAX_SS == FF_MIN_SS
+#define SDBENCH_SECTOR_SIZE(fs) FF_MAX_SS
+#else
+#define SDBENCH_SECTOR_SIZE(fs) ((fs)->ssize)
+#endif
+
+// ========================================
+// TYPES
+// ========================================
+
+struct SDBenchState {
+    bool running;
+    int test;                   // current test
+    uint32_t op;                // next operation of the current test
+    int64_t start;              // us timestamp of the current test start
+    uint32_t seed;              // random offset generator state
+    FILE* file;
+    uint8_t* buffer;
+    PocuterConfig* config;      // ini settings file
+    PocuterUtil::KVStore* store;// key-value settings log
+    uint32_t iniSize;           // estimated ini file size
+    char dir[128];
+    char data[160];             // sequential and random test file
+    char report[160];           // csv report file
+    char log[160];              // key-value settings log
+    char status[32];
+    uint32_t latency[SDBENCH_MAX_OPS];
+};
+
+// ========================================
+// PROTOTYPES
+// ========================================
+
+static bool sdBenchBeginTest();
+static bool sdBenchRunOp();
+static bool sdBenchEndTest();
+static void sdBenchFinish();
+static void sdBenchFail(const char *message);
+
+// ========================================
+// GLOBALS
+// ========================================
+
+static SDBenchState bench;
+static SDBenchResult results[SDBENCH_TEST_COUNT] = {
+    { "SEQ WRITE" },
+    { "SEQ READ" },
+    { "RAND 4K READ" },
+    { "RAND 4K WRITE" },
+    { "FILE CREATE" },
+    { "FILE RENAME" },
+    { "FILE DELETE" },
+    { "INI SET" },
+    { "INI GET" },
+    { "KV PUT" },
+    { "KV GET" },
+    { "KV OPEN" },
+};
+static const uint32_t testOps[SDBENCH_TEST_COUNT] = {
+    SDBENCH_SEQ_OPS, SDBENCH_SEQ_OPS,
+    SDBENCH_RAND_OPS, SDBENCH_RAND_OPS,
+    SDBENCH_FILE_OPS, SDBENCH_FILE_OPS, SDBENCH_FILE_OPS,
+    SDBENCH_SETTING_OPS, SDBENCH_SETTING_OPS,
+    SDBENCH_SETTING_OPS, SDBENCH_SETTING_OPS, SDBENCH_KV_OPENS,
+};
+
+// ========================================
+// FUNCTIONS
+// ========================================
+
+static uint32_t sdBenchRandom() {
+    // xorshift32 -- fixed seed so every card sees the same offsets
+    bench.seed ^= bench.seed << 13;
+    bench.seed ^= bench.seed >> 17;
+    bench.seed ^= bench.seed << 5;
+    return bench.seed;
+}
+
+static int sdBenchCompare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void sdBenchFilePath(char *dest, size_t max, uint32_t index, const char *ext) {
+    snprintf(dest, max, "%s/f%03u.%s", bench.dir, index, ext);
+}
+
+static void sdBenchSetting(char *name, char *key, char *value, uint32_t index) {
+    // same names for both stores, random values so no write is skipped as unchanged
+    snprintf(name, 16, "key%02u", index);
+    snprintf(key, 32, "%s/%s", SDBENCH_SETTING_SECTION, name);
+    snprintf(value, 24, "%08x%08x", sdBenchRandom(), sdBenchRandom());
+}
+
+static void sdBenchCloseSettings() {
+    delete bench.config;
+    delete bench.store;
+    bench.config = NULL;
+    bench.store = NULL;
+}
+
+bool sdBenchStart(const char *mountPoint) {
+    if (bench.running)
+        return false;
+
+    snprintf(bench.dir, sizeof(bench.dir), "%s/sdbench", mountPoint);
+    snprintf(bench.data, sizeof(bench.data), "%s/data.bin", bench.dir);
+    snprintf(bench.report, sizeof(bench.report), "%s/report.csv", bench.dir);
+    snprintf(bench.log, sizeof(bench.log), "%s/settings.kvl", bench.dir);
+    if (access(bench.dir, F_OK) != 0 && mkdir(bench.dir, S_IRWXU) != 0) {
+        sdBenchFail("MKDIR FAILED");
+        return false;
+    }
+
+    bench.buffer = (uint8_t*) malloc(SDBENCH_SEQ_BLOCK);
+    if (!bench.buffer) {
+        sdBenchFail("OUT OF MEMORY");
+        return false;
+    }
+
+    // fill the write buffer with noise so cards with compressing controllers aren't favoured
+    bench.seed = SDBENCH_SEED;
+    for (int i = 0; i < SDBENCH_SEQ_BLOCK; i += 4) {
+        uint32_t value = sdBenchRandom();
+        memcpy(bench.buffer + i, &value, 4);
+    }
+
+    for (int i = 0; i < SDBENCH_TEST_COUNT; i++) {
+        results[i].ops = 0;
+        results[i].bytes = 0;
+        results[i].us = 0;
+        results[i].p50 = results[i].p99 = results[i].max = 0;
+    }
+
+    bench.seed = SDBENCH_SEED;
+    bench.file = NULL;
+    bench.config = NULL;
+    bench.store = NULL;
+    bench.test = 0;
+    bench.op = 0;
+    bench.running = true;
+    printf("SDBENCH: starting in %s\n", bench.dir);
+    return true;
+}
+
+bool sdBenchStep() {
+    if (!bench.running)
+        return false;
+
+    // run operations for one time slice so the caller can keep the display updated
+    int64_t until = esp_timer_get_time() + SDBENCH_STEP_MS * 1000;
+    while (bench.running && esp_timer_get_time() < until) {
+        if (bench.op == 0 && !sdBenchBeginTest()) {
+            sdBenchFail("OPEN FAILED");
+            break;
+        }
+
+        int64_t start = esp_timer_get_time();
+        if (!sdBenchRunOp()) {
+            sdBenchFail(bench.test < SDBENCH_FILE_CREATE ? "I/O FAILED" : bench.test < SDBENCH_INI_SET ? "FILE OP FAILED" : "SETTING FAILED");
+            break;
+        }
+        bench.latency[bench.op++] = esp_timer_get_time() - start;
+
+        if (bench.op == testOps[bench.test]) {
+            if (!sdBenchEndTest()) {
+                sdBenchFail("FLUSH FAILED");
+                break;
+            }
+            bench.op = 0;
+            if (++bench.test == SDBENCH_TEST_COUNT)
+                sdBenchFinish();
+        }
+    }
+    return bench.running;
+}
+
+static bool sdBenchBeginTest() {
+    SDBenchResult &result = results[bench.test];
+    result.ops = 0;
+    result.bytes = 0;
+    strncpy(bench.status, result.name, sizeof(bench.status) - 1);
+
+    // open: test file unbuffered so every operation reaches the card
+    const char *mode = NULL;
+    switch (bench.test) {
+        case SDBENCH_SEQ_WRITE:  mode = "w";  break;
+        case SDBENCH_SEQ_READ:   mode = "r";  break;
+        case SDBENCH_RAND_READ:  mode = "r";  break;
+        case SDBENCH_RAND_WRITE: mode = "r+"; break;
+    }
+    if (mode) {
+        bench.file = sdOpen(bench.data, mode);
+        if (!bench.file)
+            return false;
+        setvbuf(bench.file, NULL, _IONBF, 0);
+    }
+
+    // settings: ini file through the pocuter config api, key-value log through PocuterUtil::KVStore
+    switch (bench.test) {
+        case SDBENCH_INI_SET:
+            bench.iniSize = strlen("[" SDBENCH_SETTING_SECTION "]\n");
+            // fall through
+        case SDBENCH_INI_GET:
+            bench.config = new PocuterConfig((const uint8_t *) SDBENCH_SETTING_FILE);
+            break;
+        case SDBENCH_KV_PUT:
+            remove(bench.log);
+            // fall through
+        case SDBENCH_KV_GET:
+            bench.store = new PocuterUtil::KVStore(bench.log);
+            if (!bench.store->open())
+                return false;
+            break;
+    }
+
+    bench.start = esp_timer_get_time();
+    return true;
+}
+
+static bool sdBenchRunOp() {
+    SDBenchResult &result = results[bench.test];
+    char path[160];
+    char dest[160];
+    char name[16];
+    char key[32];
+    char value[24];
+    char stored[24];
+    uint32_t written;
+    long offset;
+
+    switch (bench.test) {
+        case SDBENCH_SEQ_WRITE:
+            if (fwrite(bench.buffer, 1, SDBENCH_SEQ_BLOCK, bench.file) != SDBENCH_SEQ_BLOCK)
+                return false;
+            result.bytes += SDBENCH_SEQ_BLOCK;
+            break;
+
+        case SDBENCH_SEQ_READ:
+            if (fread(bench.buffer, 1, SDBENCH_SEQ_BLOCK, bench.file) != SDBENCH_SEQ_BLOCK)
+                return false;
+            result.bytes += SDBENCH_SEQ_BLOCK;
+            break;
+
+        case SDBENCH_RAND_READ:
+            offset = (long)(sdBenchRandom() % SDBENCH_RAND_SLOTS) * SDBENCH_RAND_BLOCK;
+            if (fseek(bench.file, offset, SEEK_SET) != 0)
+                return false;
+            if (fread(bench.buffer, 1, SDBENCH_RAND_BLOCK, bench.file) != SDBENCH_RAND_BLOCK)
+                return false;
+            result.bytes += SDBENCH_RAND_BLOCK;
+            break;
+
+        case SDBENCH_RAND_WRITE:
+            offset = (long)(sdBenchRandom() % SDBENCH_RAND_SLOTS) * SDBENCH_RAND_BLOCK;
+            if (fseek(bench.file, offset, SEEK_SET) != 0)
+                return false;
+            if (fwrite(bench.buffer, 1, SDBENCH_RAND_BLOCK, bench.file) != SDBENCH_RAND_BLOCK)
+                return false;
+            if (fsync(fileno(bench.file)) != 0)
+                return false;
+            result.bytes += SDBENCH_RAND_BLOCK;
+            break;
+
+        case SDBENCH_FILE_CREATE: {
+            sdBenchFilePath(path, sizeof(path), bench.op, "tmp");
+            FILE *file = fopen(path, "w");
+            if (!file)
+                return false;
+            size_t count = fwrite(bench.buffer, 1, SDBENCH_FILE_SIZE, file);
+            if (fclose(file) != 0 || count != SDBENCH_FILE_SIZE)
+                return false;
+            result.bytes += SDBENCH_FILE_SIZE;
+            break;
+        }
+
+        case SDBENCH_FILE_RENAME:
+            sdBenchFilePath(path, sizeof(path), bench.op, "tmp");
+            sdBenchFilePath(dest, sizeof(dest), bench.op, "ren");
+            if (rename(path, dest) != 0)
+                return false;
+            break;
+
+        case SDBENCH_FILE_DELETE:
+            sdBenchFilePath(path, sizeof(path), bench.op, "ren");
+            if (remove(path) != 0)
+                return false;
+            break;
+
+        case SDBENCH_INI_SET:
+            // bytes: the ini file is rewritten on every change -- estimated from the keys written so far
+            sdBenchSetting(name, key, value, bench.op);
+            if (!bench.config->set((const uint8_t *) SDBENCH_SETTING_SECTION, (const uint8_t *) name, (const uint8_t *) value))
+                return false;
+            bench.iniSize += strlen(name) + strlen(value) + 2;
+            result.bytes += bench.iniSize;
+            break;
+
+        case SDBENCH_INI_GET:
+            sdBenchSetting(name, key, value, bench.op);
+            if (!bench.config->get((const uint8_t *) SDBENCH_SETTING_SECTION, (const uint8_t *) name, (uint8_t *) stored, sizeof(stored)))
+                return false;
+            break;
+
+        case SDBENCH_KV_PUT:
+            // bytes: appended records as counted by the store
+            sdBenchSetting(name, key, value, bench.op);
+            written = bench.store->stats.bytesWritten;
+            if (!bench.store->put(key, value))
+                return false;
+            result.bytes += bench.store->stats.bytesWritten - written;
+            break;
+
+        case SDBENCH_KV_GET:
+            sdBenchSetting(name, key, value, bench.op);
+            if (!bench.store->get(key, stored, sizeof(stored)))
+                return false;
+            break;
+
+        case SDBENCH_KV_OPEN: {
+            PocuterUtil::KVStore store(bench.log);
+            if (!store.open() || store.size() != SDBENCH_SETTING_OPS)
+                return false;
+            break;
+        }
+    }
+
+    result.ops++;
+    return true;
+}
+
+static bool sdBenchEndTest() {
+    SDBenchResult &result = results[bench.test];
+    bool ok = true;
+
+    // close: written data must be on the card before the test time is taken
+    if (bench.file) {
+        if (bench.test == SDBENCH_SEQ_WRITE || bench.test == SDBENCH_RAND_WRITE)
+            ok = fsync(fileno(bench.file)) == 0;
+        ok = sdClose(bench.file) == 0 && ok;
+        bench.file = NULL;
+    }
+    sdBenchCloseSettings();
+    result.us = esp_timer_get_time() - bench.start;
+
+    // stats: latency percentiles by nearest rank
+    uint32_t count = result.ops;
+    qsort(bench.latency, count, sizeof(uint32_t), sdBenchCompare);
+    result.p50 = bench.latency[(count * 50 + 99) / 100 - 1];
+    result.p99 = bench.latency[(count * 99 + 99) / 100 - 1];
+    result.max = bench.latency[count - 1];
+
+    printf("SDBENCH: %-13s %8.3f MB/s %8.1f IOPS  p50 %6u us  p99 %6u us  max %6u us\n",
+        result.name, sdBenchMBps(&result), sdBenchIOPS(&result), result.p50, result.p99, result.max);
+    if (result.bytes && bench.test >= SDBENCH_INI_SET)
+        printf("SDBENCH: %-13s %8llu bytes per update\n", result.name, result.bytes / result.ops);
+    return ok;
+}
+
+static void sdBenchFinish() {
+    bench.running = false;
+    remove(bench.data);
+    remove(bench.log);
+    free(bench.buffer);
+    bench.buffer = NULL;
+
+    // card: capacity identifies the card model in the report
+    FATFS *fs;
+    DWORD freeClusters;
+    uint32_t cardMB = 0;
+    char drive[8];
+    if (sdServiceFatDrive(drive) && f_getfree(drive, &freeClusters, &fs) == FR_OK)
+        cardMB = (uint64_t)(fs->n_fatent - 2) * fs->csize * SDBENCH_SECTOR_SIZE(fs) / (1024 * 1024);
+
+    tm time;
+    char stamp[24];
+    pocuter->PocTime->getLocalTime(&time);
+    snprintf(stamp, sizeof(stamp), "%04d-%02d-%02d %02d:%02d:%02d",
+        time.tm_year + 1900, time.tm_mon + 1, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+
+    // report: append one row per test, header on a new file
+    bool exists = access(bench.report, F_OK) == 0;
+    FILE *file = fopen(bench.report, "a");
+    if (!file) {
+        strcpy(bench.status, "REPORT FAILED");
+        return;
+    }
+    if (!exists)
+        fprintf(file, "time,card_mb,test,ops,bytes,seconds,mb_per_s,iops,p50_us,p99_us,max_us\n");
+    for (int i = 0; i < SDBENCH_TEST_COUNT; i++) {
+        const SDBenchResult &result = results[i];
+        fprintf(file, "%s,%u,%s,%u,%llu,%.6f,%.3f,%.1f,%u,%u,%u\n",
+            stamp, cardMB, result.name, result.ops, result.bytes, result.us / 1000000.0,
+            sdBenchMBps(&result), sdBenchIOPS(&result), result.p50, result.p99, result.max);
+    }
+    fclose(file);
+
+    strcpy(bench.status, "DONE");
+    printf("SDBENCH: report written to %s\n", bench.report);
+}
+
+static void sdBenchFail(const char *message) {
+    printf("SDBENCH: %s during %s (errno %d)\n", message, results[bench.test % SDBENCH_TEST_COUNT].name, errno);
+    if (bench.file)
+        sdClose(bench.file);
+    sdBenchCloseSettings();
+    if (bench.data[0])
+        remove(bench.data);
+    if (bench.log[0])
+        remove(bench.log);
+    free(bench.buffer);
+    bench.file = NULL;
+    bench.buffer = NULL;
+    bench.running = false;
+    strncpy(bench.status, message, sizeof(bench.status) - 1);
+}
+
+void sdBenchAbort(const char *message) {
+    if (bench.running)
+        sdBenchFail(message);
+}
+
+bool sdBenchRunning() {
+    return bench.running;
+}
+
+int sdBenchProgress() {
+    uint32_t done = bench.op;
+    uint32_t total = 0;
+    for (int i = 0; i < SDBENCH_TEST_COUNT; i++) {
+        if (i < bench.test)
+            done += testOps[i];
+        total += testOps[i];
+    }
+    return bench.running ? done * 100 / total : 100;
+}
+
+const char* sdBenchStatus() {
+    return bench.status;
+}
+
+const SDBenchResult* sdBenchResult(int test) {
+    if (test < 0 || test >= SDBENCH_TEST_COUNT)
+        return NULL;
+    return &results[test];
+}
+
+const char* sdBenchReportPath() {
+    return bench.report;
+}
+
+double sdBenchMBps(const SDBenchResult *result) {
+    // decimal megabytes -- bytes per microsecond
+    return result->us ? (double)result->bytes / result->us : 0.0;
+}
+
+double sdBenchIOPS(const SDBenchResult *result) {
+    return result->us ? result->ops * 1000000.0 / result->us : 0.0;
+}
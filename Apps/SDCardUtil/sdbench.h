@@ -0,0 +1,75 @@
+#ifndef _SDBENCH_H_
+#define _SDBENCH_H_
+// ========================================
+// INCLUDES
+// ========================================
+
+#include <Arduino.h>
+
+// ========================================
+// MACROS
+// ========================================
+
+#define SDBENCH_SEQ_SIZE        (4*1024*1024)   // sequential test file size
+#define SDBENCH_SEQ_BLOCK       (32*1024)       // sequential read/write block size
+#define SDBENCH_RAND_BLOCK      4096            // random read/write block size
+#define SDBENCH_RAND_OPS        256             // random reads/writes per test
+#define SDBENCH_FILE_OPS        64              // small files created, renamed, and deleted
+#define SDBENCH_FILE_SIZE       512             // small file size
+#define SDBENCH_SETTING_OPS     64              // settings written and read through the ini file and the key-value log
+#define SDBENCH_KV_OPENS        16              // key-value log opens -- replays the log written by the KV PUT test
+#define SDBENCH_MAX_OPS         256             // latency samples per test
+#define SDBENCH_STEP_MS         30              // time slice of a single sdBenchStep() call
+#define SDBENCH_SEED            0x5D5D5D5D      // fixed random seed -- same access pattern on every card
+
+// ========================================
+// TYPES
+// ========================================
+
+enum SDBenchTest {
+    SDBENCH_SEQ_WRITE,
+    SDBENCH_SEQ_READ,
+    SDBENCH_RAND_READ,
+    SDBENCH_RAND_WRITE,
+    SDBENCH_FILE_CREATE,
+    SDBENCH_FILE_RENAME,
+    SDBENCH_FILE_DELETE,
+    SDBENCH_INI_SET,
+    SDBENCH_INI_GET,
+    SDBENCH_KV_PUT,
+    SDBENCH_KV_GET,
+    SDBENCH_KV_OPEN,
+    SDBENCH_TEST_COUNT
+};
+
+struct SDBenchResult {
+    const char* name;
+    uint32_t ops;           // completed operations
+    uint64_t bytes;         // bytes read or written, settings tests: bytes written to the card (ini: estimated file rewrites)
+    uint64_t us;            // total test time including the final flush
+    uint32_t p50;           // operation latency percentiles in us
+    uint32_t p99;
+    uint32_t max;
+};
+
+// ========================================
+// PROTOTYPES
+// ========================================
+
+extern bool sdBenchStart(const char *mountPoint);
+extern bool sdBenchStep();
+extern void sdBenchAbort(const char *message);
+extern bool sdBenchRunning();
+extern int  sdBenchProgress();
+extern const char* sdBenchStatus();
+extern const SDBenchResult* sdBenchResult(int test);
+extern const char* sdBenchReportPath();
+
+extern double sdBenchMBps(const SDBenchResult *result);
+extern double sdBenchIOPS(const SDBenchResult *result);
+
+// ========================================
+// GLOBALS
+// ========================================
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef _SDSERVICE_H_
+#define _SDSERVICE_H_
+// ========================================
+// INCLUDES
+// ========================================
+
+#include <Arduino.h>
+
+// ========================================
+// MACROS
+// ========================================
+
+#define SDSERVICE_POLL_MS       100     // card detect poll interval
+#define SDSERVICE_DEBOUNCE      3       // equal samples before a card change is reported
+#define SDSERVICE_MAX_FILES     8       // open files tracked for the pre-unmount flush
+#define SDSERVICE_REMOVE_WAIT   1000    // ms the owners of open files get to close them after a card removal
+#define SDSERVICE_QUEUE_SIZE    8
+#define SDSERVICE_TASK_STACK    4096
+#define SDSERVICE_TASK_PRIORITY 1
+#define SDSERVICE_DRIVE_PROBE   ".sdservice.drive"  // file written through the vfs to find the fatfs drive of the card
+
+// ========================================
+// TYPES
+// ========================================
+
+enum SDServiceState {
+    SDSERVICE_NO_CARD,
+    SDSERVICE_UNMOUNTED,
+    SDSERVICE_MOUNTING,
+    SDSERVICE_MOUNTED,
+    SDSERVICE_UNMOUNTING,
+};
+
+enum SDServiceEventType {
+    SDSERVICE_EVENT_INSERTED,
+    SDSERVICE_EVENT_REMOVED,
+    SDSERVICE_EVENT_MOUNTED,
+    SDSERVICE_EVENT_MOUNT_FAILED,
+    SDSERVICE_EVENT_UNMOUNTED,
+    SDSERVICE_EVENT_FILES_OPEN,     // unmount refused -- files were flushed but are still open
+};
+
+struct SDServiceEvent {
+    SDServiceEventType type;
+    uint32_t us;                    // duration of the mount/unmount operation
+    int openFiles;                  // files still open when unmounting, or dropped by a card removal
+    FILE* files[SDSERVICE_MAX_FILES]; // removed: files of the removed card -- owners sdClose() them before the unmount
+};
+
+// ========================================
+// PROTOTYPES
+// ========================================
+
+extern void sdServiceBegin(bool autoMount);
+extern bool sdServiceGetEvent(SDServiceEvent *event);
+extern void sdServiceMount();
+extern void sdServiceUnmount(bool force = false);
+extern SDServiceState sdServiceState();
+extern bool sdServiceIsMounted();
+extern uint32_t sdServiceElapsed();
+extern const char* sdServiceEventName(SDServiceEventType type);
+extern bool sdServiceFatDrive(char *drive);
+
+extern FILE* sdOpen(const char *path, const char *mode);
+extern int sdClose(FILE *file);
+extern int sdServiceOpenFiles();
+
+// ========================================
+// GLOBALS
+// ========================================
+
+#endif
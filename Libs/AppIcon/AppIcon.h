@@ -0,0 +1,378 @@
+//
+// Copyright 2023 Kallistisoft
+// GNU GPL-3 https://www.gnu.org/licenses/gpl-3.0.txt
+/*
+* [PocuterUtils]/Libs/AppIcon/AppIcon.h
+*
+* PocuterUtils::AppIcon -- Decoder for application icons of the [APPDATA] metadata block
+*
+* See README.md file for details, icon format, and usage guide
+*/
+
+#ifndef _POCUTERUTIL_APPICON_H_
+#define _POCUTERUTIL_APPICON_H_
+
+#include <Pocuter.h>
+#include <cstdio>
+#include <cstring>
+
+// global: icon formats
+#define APPICON_SIZE            16          /**< width and height of rgba icons */
+#define APPICON_PIXELS_MAX      (32*32)     /**< largest rgb565 icon */
+#define APPICON_DATA_MAX        1024        /**< largest decoded AppIcon value */
+#define APPICON_RGB565_TAG      "RGB565"    /**< AppIconFormat value of the compact encoding */
+#define APPICON_RGB565_VERSION  1           /**< first byte of the compact encoding */
+
+// global: app image metadata block
+#define APPICON_META_MAX        4096        /**< bytes of an app image searched for the metadata block */
+#define APPICON_META_OFFSET     64          /**< largest offset of the '[APPDATA]' header in an app image */
+
+// local: rgb565 header and run-length control bytes
+#define APPICON_HEADER          4           /**< [version:u8][width:u8][height:u8][colors:u8] */
+#define APPICON_RUN             0x80        /**< control bit: repeat the next item (control & 0x7F) + 2 times */
+
+// ------------------------------------------------------------------------------------------------
+//
+//	Use the 'PocuterUtil' namespace
+//
+namespace PocuterUtil {
+/**
+* @brief PocuterUtil::AppIconFormat -- Encoding of a loaded icon
+*/
+enum AppIconFormat {
+	APPICON_NONE,       /**< no icon loaded */
+	APPICON_RGBA,       /**< 16x16 rgba pixels, the original AppIcon value */
+	APPICON_RGB565      /**< rgb565 colors with palette and run-length compression, AppIconFormat=RGB565 */
+};
+
+/**
+* @brief PocuterUtil::AppIcon -- Application icon decoder
+*
+* Decodes the base64 AppIcon value of an application and draws it with UGUI. Both the original
+* 16x16 rgba pixels and the compact rgb565 encoding are supported, the decoded value is kept in a
+* fixed buffer and pixels are never expanded into an intermediate image. Runs of equal pixels are
+* drawn as a single line, other pixels one at a time.
+*
+* @note See README.md file for details, icon format, and usage guide
+*/
+// ------------------------------------------------------------------------------------------------
+class AppIcon {
+	private:
+		// decoded value and the parts of an rgb565 icon
+		uint8_t data[APPICON_DATA_MAX];
+		size_t length;
+		const uint8_t *palette;
+		const uint8_t *stream;
+		uint16_t colors;
+
+		static int base64( char c );
+		static const char* metaValue( const char *block, const char *key );
+		static uint32_t rgb888( uint16_t color );
+		static uint16_t rgb565( const uint8_t *rgb );
+
+		template<typename Emit> bool runs( Emit emit ) const;
+
+	public:
+		AppIconFormat format;   /**< encoding of the loaded icon */
+		uint8_t width;          /**< icon width in pixels */
+		uint8_t height;         /**< icon height in pixels */
+
+		AppIcon();
+
+		bool load( const char *value, const char *format = NULL );
+		bool loadApp( const char *path );
+		void clear();
+
+		void draw( UGUI *gui, int x, int y ) const;
+		bool decode( uint16_t *dest ) const;
+		size_t size() const;
+};
+/**
+ * @brief AppIcon Constructor -- no icon is loaded
+*/
+inline AppIcon::AppIcon() {
+	this->clear();
+}
+
+
+/**
+ * @brief Unload the icon
+*/
+inline void AppIcon::clear() {
+	this->length = 0;
+	this->palette = NULL;
+	this->stream = NULL;
+	this->colors = 0;
+	this->format = APPICON_NONE;
+	this->width = 0;
+	this->height = 0;
+}
+
+
+/**
+ * @brief Value of a base64 character
+ *
+ * @return 0 to 63, -1 for padding and invalid characters
+*/
+inline int AppIcon::base64( char c ) {
+	if( c >= 'A' && c <= 'Z' ) return c - 'A';
+	if( c >= 'a' && c <= 'z' ) return c - 'a' + 26;
+	if( c >= '0' && c <= '9' ) return c - '0' + 52;
+	if( c == '+' ) return 62;
+	if( c == '/' ) return 63;
+	return -1;
+}
+
+
+/**
+ * @brief Expand an rgb565 color to the 24-bit colors used by UGUI
+*/
+inline uint32_t AppIcon::rgb888( uint16_t color ) {
+	uint32_t r = (color >> 11) & 0x1F;
+	uint32_t g = (color >> 5) & 0x3F;
+	uint32_t b = color & 0x1F;
+	return ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+}
+
+
+/**
+ * @brief Reduce an rgb pixel to rgb565
+*/
+inline uint16_t AppIcon::rgb565( const uint8_t *rgb ) {
+	return (rgb[0] >> 3) << 11 | (rgb[1] >> 2) << 5 | rgb[2] >> 3;
+}
+
+
+/**
+ * @brief Load an icon from its AppIcon value
+ *
+ * @param value base64 AppIcon value
+ * @param format AppIconFormat value, NULL or empty for rgba icons
+ *
+ * @return boolean flag indicating a valid icon was loaded
+*/
+inline bool AppIcon::load( const char *value, const char *format ) {
+	this->clear();
+	if( !value ) return false;
+
+	// decode: base64 value into the fixed buffer, stops at padding or the end of the line
+	uint32_t bits = 0;
+	int count = 0;
+	size_t len = 0;
+	for( const char *c = value; *c; c++ ) {
+		int v = base64( *c );
+		if( v < 0 ) break;
+		bits = bits << 6 | v;
+		count += 6;
+		if( count >= 8 ) {
+			if( len == APPICON_DATA_MAX ) return false;
+			count -= 8;
+			this->data[len++] = bits >> count;
+		}
+	}
+	this->length = len;
+
+	// rgba: fixed size 16x16 pixels
+	if( !format || !*format ) {
+		if( len != APPICON_SIZE * APPICON_SIZE * 4 ) return false;
+		this->format = APPICON_RGBA;
+		this->width = this->height = APPICON_SIZE;
+		return true;
+	}
+
+	// rgb565: header, optional palette, and run-length stream -- checked once so drawing can't fail
+	if( strcmp( format, APPICON_RGB565_TAG ) != 0 || len < APPICON_HEADER || this->data[0] != APPICON_RGB565_VERSION ) return false;
+	this->width = this->data[1];
+	this->height = this->data[2];
+	this->colors = this->data[3];
+	this->palette = this->data + APPICON_HEADER;
+	this->stream = this->palette + this->colors * 2;
+	if( !this->width || !this->height || this->width * this->height > APPICON_PIXELS_MAX || this->stream > this->data + len ) {
+		this->clear();
+		return false;
+	}
+	this->format = APPICON_RGB565;
+	if( !this->runs( []( uint32_t, uint32_t, uint32_t ) {} ) ) {
+		this->clear();
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * @brief Step through the pixels of the icon as runs of equal colors
+ *
+ * @param emit called with the 24-bit color, the index of the first pixel, and the pixel count
+ *
+ * @return boolean flag indicating the icon data was complete and valid
+*/
+template<typename Emit>
+inline bool AppIcon::runs( Emit emit ) const {
+	uint32_t total = this->width * this->height;
+	uint32_t pos = 0;
+
+	// rgba: equal neighbours are merged into runs
+	if( this->format == APPICON_RGBA ) {
+		const uint8_t *p = this->data;
+		while( pos < total ) {
+			uint32_t n = 1;
+			while( pos + n < total && memcmp( p, p + n * 4, 3 ) == 0 ) n++;
+			emit( (uint32_t) p[0] << 16 | p[1] << 8 | p[2], pos, n );
+			pos += n;
+			p += n * 4;
+		}
+		return true;
+	}
+	if( this->format != APPICON_RGB565 ) return false;
+
+	// rgb565: control byte, then one item repeated or up to 128 literal items
+	const uint8_t *s = this->stream;
+	const uint8_t *end = this->data + this->length;
+	size_t item = this->colors ? 1 : 2;
+	while( pos < total ) {
+		if( s >= end ) return false;
+		uint8_t control = *s++;
+		bool run = control & APPICON_RUN;
+		uint32_t n = run ? (control & ~APPICON_RUN) + 2 : control + 1;
+		if( pos + n > total || s + (run ? 1 : n) * item > end ) return false;
+		for( uint32_t i = 0; i < (run ? 1 : n); i++ ) {
+			uint16_t color;
+			if( this->colors ) {
+				if( *s >= this->colors ) return false;
+				color = this->palette[*s * 2] | this->palette[*s * 2 + 1] << 8;
+			} else {
+				color = s[0] | s[1] << 8;
+			}
+			s += item;
+			emit( rgb888( color ), pos, run ? n : 1 );
+			pos += run ? n : 1;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * @brief Draw the icon
+ *
+ * @note runs of equal pixels are split at the end of each row and drawn as lines
+ *
+ * @param gui UGUI instance to draw with
+ * @param x left edge of the icon
+ * @param y top edge of the icon
+*/
+inline void AppIcon::draw( UGUI *gui, int x, int y ) const {
+	uint32_t w = this->width;
+	this->runs( [gui, x, y, w]( uint32_t color, uint32_t pos, uint32_t count ) {
+		while( count ) {
+			int px = pos % w;
+			int py = pos / w;
+			uint32_t n = w - px < count ? w - px : count;
+			if( n == 1 ) gui->UG_DrawPixel( x + px, y + py, color );
+			else gui->UG_DrawLine( x + px, y + py, x + px + n - 1, y + py, color );
+			pos += n;
+			count -= n;
+		}
+	});
+}
+
+
+/**
+ * @brief Decode the icon to rgb565 pixels
+ *
+ * @param dest buffer for width * height pixels, rows from top to bottom
+ *
+ * @return boolean flag indicating an icon is loaded
+*/
+inline bool AppIcon::decode( uint16_t *dest ) const {
+	if( this->format == APPICON_NONE ) return false;
+	return this->runs( [dest]( uint32_t color, uint32_t pos, uint32_t count ) {
+		uint8_t rgb[3] = { (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t) color };
+		uint16_t pixel = rgb565( rgb );
+		while( count-- ) dest[pos++] = pixel;
+	});
+}
+
+
+/**
+ * @brief Size of the decoded AppIcon value
+ *
+ * @return bytes, 0 if no icon is loaded
+*/
+inline size_t AppIcon::size() const {
+	return this->format == APPICON_NONE ? 0 : this->length;
+}
+
+
+/**
+ * @brief Find a key in a metadata block
+ *
+ * @note the value isn't terminated, it ends at the end of its line
+ *
+ * @return pointer to the value, NULL if the key isn't set
+*/
+inline const char* AppIcon::metaValue( const char *block, const char *key ) {
+	size_t keylen = strlen( key );
+	for( const char *line = block; line && *line; ) {
+		const char *next = strpbrk( line, "\r\n" );
+		if( strncmp( line, key, keylen ) == 0 && line[keylen] == '=' ) return line + keylen + 1;
+		line = next ? next + strspn( next, "\r\n" ) : NULL;
+	}
+	return NULL;
+}
+
+
+/**
+ * @brief Load the icon of an installed application
+ *
+ * @note the metadata block is the ascii '[APPDATA]' section near the start of the app image
+ *
+ * @param path app image, for example: "/sd/apps/1234/esp32c3.app"
+ *
+ * @return boolean flag indicating a valid icon was loaded
+*/
+inline bool AppIcon::loadApp( const char *path ) {
+	this->clear();
+	FILE *file = fopen( path, "rb" );
+	if( !file ) return false;
+	char *block = (char*) malloc( APPICON_META_MAX + 1 );
+	size_t len = block ? fread( block, 1, APPICON_META_MAX, file ) : 0;
+	fclose( file );
+	if( !block ) return false;
+
+	// block: starts at the section header, ends at the first byte that isn't ascii text
+	char *start = NULL;
+	for( size_t i = 0; i + 9 <= len && i <= APPICON_META_OFFSET; i++ ) {
+		if( memcmp( block + i, "[APPDATA]", 9 ) == 0 ) {
+			start = block + i;
+			break;
+		}
+	}
+	bool loaded = false;
+	if( start ) {
+		char *end = start;
+		while( end < block + len && ((*end >= 32 && *end < 127) || *end == '\t' || *end == '\r' || *end == '\n') ) end++;
+		*end = '\0';
+
+		// values: the icon ends at the first character that isn't base64, the format is copied up to the line end
+		const char *format = metaValue( start, "AppIconFormat" );
+		char tag[8] = "";
+		size_t taglen = format ? strcspn( format, "\r\n" ) : 0;
+		if( taglen < sizeof(tag) ) memcpy( tag, format, taglen );
+		loaded = this->load( metaValue( start, "AppIcon" ), tag );
+	}
+	free( block );
+	return loaded;
+}
+
+/*
+	Close the 'PocuterUtil' namespace
+*/
+};
+
+// undefine internal macros and constants
+#undef APPICON_HEADER
+#undef APPICON_RUN
+
+#endif // _POCUTERUTIL_APPICON_H_
@@ -0,0 +1,708 @@
+//
+// Copyright 2023 Kallistisoft
+// GNU GPL-3 https://www.gnu.org/licenses/gpl-3.0.txt
+/*
+* [PocuterUtils]/Libs/KVStore/KVStore.h
+*
+* PocuterUtils::KVStore -- Log-structured key-value store for app settings on the sd card
+*
+* See README.md file for details, file format, and usage guide
+*/
+
+#ifndef _POCUTERUTIL_KVSTORE_H_
+#define _POCUTERUTIL_KVSTORE_H_
+
+#include <Arduino.h>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <esp_timer.h>
+
+// global: log file format
+#define KVSTORE_MAGIC           "PKV1"  /**< log file signature and version */
+#define KVSTORE_HEADER          8       /**< record header: [type:u8][keylen:u8][vallen:u16][crc32:u32] */
+#define KVSTORE_KEY_MAX         64      /**< longest key */
+#define KVSTORE_VALUE_MAX       1024    /**< longest value */
+
+// global: compaction thresholds
+#define KVSTORE_COMPACT_MIN     4096    /**< logs smaller than this are never compacted */
+#define KVSTORE_COMPACT_RATIO   4       /**< compact when the log is this many times the size of the live records */
+
+// local: record types and index slot markers
+#define KVSTORE_TYPE_PUT        'P'
+#define KVSTORE_TYPE_DELETE     'D'
+#define KVSTORE_SLOT_EMPTY      0
+#define KVSTORE_SLOT_DELETED    1
+#define KVSTORE_INDEX_MIN       16
+
+// ------------------------------------------------------------------------------------------------
+//
+//	Use the 'PocuterUtil' namespace
+//
+namespace PocuterUtil {
+/**
+* @brief PocuterUtil::KVStoreStats -- Key-value store statistics
+*/
+struct KVStoreStats {
+	uint32_t openUs;        /**< time to open the log and build the index */
+	uint32_t records;       /**< records read when opening */
+	uint32_t recovered;     /**< bytes of a torn record dropped when opening */
+	uint32_t bytesWritten;  /**< bytes appended or copied by compaction */
+	uint32_t puts;          /**< records appended */
+	uint32_t compactions;   /**< log compactions */
+};
+
+/**
+* @brief PocuterUtil::KVStore -- Log-structured key-value store
+*
+* Every change is appended to the log as a checksummed record, the file is never rewritten in
+* place. Opening the log replays it into a small hash index of record offsets, a torn record at
+* the end of the log is dropped. The log is compacted into a new file once it mostly holds
+* overwritten records.
+*
+* @note See README.md file for details, file format, and usage guide
+*/
+// ------------------------------------------------------------------------------------------------
+class KVStore {
+	private:
+		// index slot: hash of the key, offset and size of the live record
+		struct Slot {
+			uint32_t hash;
+			uint32_t offset;
+			uint16_t size;
+		};
+
+		// log file
+		char path[96];
+		FILE *file;
+		uint32_t fileSize;
+		uint32_t liveSize;
+
+		// open-addressing hash index
+		Slot *index;
+		uint32_t capacity;
+		uint32_t count;
+		uint32_t used;
+
+		static uint32_t crc32( uint32_t crc, const uint8_t *data, size_t len );
+		static uint32_t hash( const char *key );
+
+		int find( const char *key, uint32_t hash );
+		bool insert( uint32_t hash, uint32_t offset, uint16_t size );
+		bool grow();
+		bool readKey( uint32_t offset, char *key );
+		bool append( uint8_t type, const char *key, const char *value, uint32_t *offset );
+		bool replay();
+		void closeFile();
+
+	public:
+		bool autoSync;        /**< flag: sync the log after every change (default: true) */
+		KVStoreStats stats;   /**< store statistics */
+
+		KVStore( const char *path );
+		~KVStore();
+
+		bool open();
+		void close();
+		bool isOpen();
+
+		bool get( const char *key, char *dest, size_t maxLength );
+		bool put( const char *key, const char *value );
+		bool remove( const char *key );
+		bool sync();
+		bool compact();
+		uint32_t size();
+
+		bool importIni( const char *path );
+		bool exportIni( const char *path );
+};
+/**
+ * @brief KVStore Constructor -- the log is opened by open()
+ *
+ * @param path full path of the log file, for example: "/sd/apps/1234/settings.kvl"
+*/
+inline KVStore::KVStore( const char *path ) {
+	memset( this->path, 0, sizeof(this->path) );
+	strncpy( this->path, path, sizeof(this->path) - 1 );
+	this->file = NULL;
+	this->index = NULL;
+	this->capacity = 0;
+	this->count = 0;
+	this->used = 0;
+	this->fileSize = 0;
+	this->liveSize = 0;
+	this->autoSync = true;
+	memset( &this->stats, 0, sizeof(KVStoreStats) );
+}
+
+
+/**
+ * @brief KVStore Destructor
+*/
+inline KVStore::~KVStore() {
+	this->close();
+}
+
+
+/**
+ * @brief update crc32 (ieee 802.3) with a nibble table
+*/
+inline uint32_t KVStore::crc32( uint32_t crc, const uint8_t *data, size_t len ) {
+	static const uint32_t table[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+	};
+	crc = ~crc;
+	while( len-- ) {
+		crc = table[ (crc ^ *data) & 0x0F ] ^ (crc >> 4);
+		crc = table[ (crc ^ (*data++ >> 4)) & 0x0F ] ^ (crc >> 4);
+	}
+	return ~crc;
+}
+
+
+/**
+ * @brief fnv-1a hash of a key
+*/
+inline uint32_t KVStore::hash( const char *key ) {
+	uint32_t hash = 2166136261u;
+	while( *key ) hash = (hash ^ (uint8_t) *key++) * 16777619u;
+	return hash;
+}
+
+
+/**
+ * @brief open the log and build the index -- creates the log when missing
+ *
+ * @note an interrupted compaction is completed, a torn record at the end of the log is truncated
+ *
+ * @return boolean flag indicating if the store is usable
+*/
+inline bool KVStore::open() {
+	if( this->file ) return true;
+	int64_t start = esp_timer_get_time();
+
+	// recover: compaction was interrupted after the old log was moved aside
+	char other[sizeof(this->path) + 4];
+	snprintf( other, sizeof(other), "%s.old", this->path );
+	if( access( this->path, F_OK ) != 0 && access( other, F_OK ) == 0 )
+		rename( other, this->path );
+	else
+		::remove( other );
+	snprintf( other, sizeof(other), "%s.tmp", this->path );
+	::remove( other );
+
+	// open: existing log, or a new log with just the signature
+	this->file = fopen( this->path, "r+b" );
+	if( !this->file ) {
+		this->file = fopen( this->path, "w+b" );
+		if( !this->file || fwrite( KVSTORE_MAGIC, 1, 4, this->file ) != 4 || fflush( this->file ) != 0 ) {
+			this->closeFile();
+			return false;
+		}
+		this->stats.bytesWritten += 4;
+	}
+
+	if( !this->replay() ) {
+		this->closeFile();
+		return false;
+	}
+	this->stats.openUs = esp_timer_get_time() - start;
+	return true;
+}
+
+
+/**
+ * @brief read all records into the index -- only a torn or corrupt tail is truncated
+ *
+ * @return boolean flag indicating if the file is a valid log and all records were indexed,
+ * the file is left untouched when a record can't be indexed or the file can't be read
+*/
+inline bool KVStore::replay() {
+	char magic[4];
+	if( fseek( this->file, 0, SEEK_SET ) != 0 || fread( magic, 1, 4, this->file ) != 4 || memcmp( magic, KVSTORE_MAGIC, 4 ) != 0 )
+		return false;
+
+	free( this->index );
+	this->index = NULL;
+	this->capacity = 0;
+	this->count = 0;
+	this->used = 0;
+	this->liveSize = 0;
+	this->stats.records = 0;
+
+	// scan: records until the end of the file or the first invalid record
+	uint8_t *data = (uint8_t*) malloc( KVSTORE_KEY_MAX + KVSTORE_VALUE_MAX + 1 );
+	if( !data ) return false;
+	uint32_t offset = 4;
+	bool failed = false;
+	uint8_t header[KVSTORE_HEADER];
+	while( fread( header, 1, KVSTORE_HEADER, this->file ) == KVSTORE_HEADER ) {
+		uint8_t type = header[0];
+		uint8_t keylen = header[1];
+		uint16_t vallen = header[2] | (header[3] << 8);
+		uint32_t crc = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t) header[7] << 24);
+		if( (type != KVSTORE_TYPE_PUT && type != KVSTORE_TYPE_DELETE) || !keylen || keylen > KVSTORE_KEY_MAX || vallen > KVSTORE_VALUE_MAX ) break;
+		if( fread( data, 1, keylen + vallen, this->file ) != (size_t)(keylen + vallen) ) break;
+		if( crc != this->crc32( this->crc32( 0, header, 4 ), data, keylen + vallen ) ) break;
+
+		// apply: the latest record of a key replaces its slot
+		char key[KVSTORE_KEY_MAX + 1];
+		memcpy( key, data, keylen );
+		key[keylen] = '\0';
+		uint32_t hash = this->hash( key );
+		uint16_t size = KVSTORE_HEADER + keylen + vallen;
+		int slot = this->find( key, hash );
+		if( slot >= 0 ) {
+			this->liveSize -= this->index[slot].size;
+			this->index[slot].offset = KVSTORE_SLOT_DELETED;
+			this->count--;
+		}
+		if( type == KVSTORE_TYPE_PUT && !this->insert( hash, offset, size ) ) {
+			failed = true;
+			break;
+		}
+
+		// seek: find() moved the file position to verify keys
+		offset += size;
+		this->stats.records++;
+		if( fseek( this->file, offset, SEEK_SET ) != 0 ) {
+			failed = true;
+			break;
+		}
+	}
+	free( data );
+
+	// failed: out of memory or a read error -- the records past this point may be valid, keep them
+	if( failed || ferror( this->file ) ) {
+		clearerr( this->file );
+		return false;
+	}
+
+	// truncate: drop a torn or corrupt tail so new records follow the last valid one
+	if( fseek( this->file, 0, SEEK_END ) != 0 ) return false;
+	long end = ftell( this->file );
+	if( end < 0 ) return false;
+	if( (uint32_t) end > offset ) {
+		this->stats.recovered += end - offset;
+		fflush( this->file );
+		if( ftruncate( fileno( this->file ), offset ) != 0 ) return false;
+	}
+	this->fileSize = offset;
+	return true;
+}
+
+
+/**
+ * @brief close the log and free the index
+*/
+inline void KVStore::close() {
+	this->closeFile();
+	free( this->index );
+	this->index = NULL;
+	this->capacity = 0;
+	this->count = 0;
+	this->used = 0;
+}
+
+
+/**
+ * @brief close the log file after writing buffered records
+*/
+inline void KVStore::closeFile() {
+	if( this->file ) {
+		fflush( this->file );
+		fsync( fileno( this->file ) );
+		fclose( this->file );
+	}
+	this->file = NULL;
+}
+
+
+/**
+ * @brief check if the log is open
+*/
+inline bool KVStore::isOpen() {
+	return this->file != NULL;
+}
+
+
+/**
+ * @brief number of keys in the store
+*/
+inline uint32_t KVStore::size() {
+	return this->count;
+}
+
+
+/**
+ * @brief read the key of a record
+ *
+ * @param key destination buffer of KVSTORE_KEY_MAX + 1 bytes
+*/
+inline bool KVStore::readKey( uint32_t offset, char *key ) {
+	uint8_t header[KVSTORE_HEADER];
+	if( fseek( this->file, offset, SEEK_SET ) != 0 || fread( header, 1, KVSTORE_HEADER, this->file ) != KVSTORE_HEADER ) return false;
+	if( fread( key, 1, header[1], this->file ) != header[1] ) return false;
+	key[ header[1] ] = '\0';
+	return true;
+}
+
+
+/**
+ * @brief find the index slot of a key -- hash matches are verified by reading the key from the log
+ *
+ * @return slot index, -1 when the key isn't in the store
+*/
+inline int KVStore::find( const char *key, uint32_t hash ) {
+	if( !this->capacity ) return -1;
+	char stored[KVSTORE_KEY_MAX + 1];
+	uint32_t mask = this->capacity - 1;
+	for( uint32_t i = hash & mask; ; i = (i + 1) & mask ) {
+		Slot &slot = this->index[i];
+		if( slot.offset == KVSTORE_SLOT_EMPTY ) return -1;
+		if( slot.offset != KVSTORE_SLOT_DELETED && slot.hash == hash && this->readKey( slot.offset, stored ) && strcmp( stored, key ) == 0 )
+			return i;
+	}
+}
+
+
+/**
+ * @brief add a record to the index, the key must not be in the index
+*/
+inline bool KVStore::insert( uint32_t hash, uint32_t offset, uint16_t size ) {
+	if( (this->used + 1) * 4 > this->capacity * 3 && !this->grow() ) return false;
+
+	uint32_t mask = this->capacity - 1;
+	uint32_t i = hash & mask;
+	while( this->index[i].offset > KVSTORE_SLOT_DELETED ) i = (i + 1) & mask;
+	if( this->index[i].offset == KVSTORE_SLOT_EMPTY ) this->used++;
+	this->index[i].hash = hash;
+	this->index[i].offset = offset;
+	this->index[i].size = size;
+	this->count++;
+	this->liveSize += size;
+	return true;
+}
+
+
+/**
+ * @brief rebuild the index with twice the capacity, dropping deleted slots
+*/
+inline bool KVStore::grow() {
+	uint32_t capacity = this->capacity ? this->capacity * 2 : KVSTORE_INDEX_MIN;
+	while( this->count * 2 >= capacity ) capacity *= 2;
+	Slot *index = (Slot*) calloc( capacity, sizeof(Slot) );
+	if( !index ) return false;
+
+	uint32_t mask = capacity - 1;
+	for( uint32_t j=0; j < this->capacity; j++ ) {
+		Slot &slot = this->index[j];
+		if( slot.offset <= KVSTORE_SLOT_DELETED ) continue;
+		uint32_t i = slot.hash & mask;
+		while( index[i].offset != KVSTORE_SLOT_EMPTY ) i = (i + 1) & mask;
+		index[i] = slot;
+	}
+	free( this->index );
+	this->index = index;
+	this->capacity = capacity;
+	this->used = this->count;
+	return true;
+}
+
+
+/**
+ * @brief get the value of a key
+ *
+ * @param key key string
+ * @param dest destination buffer, the value is truncated to maxLength - 1 characters
+ * @param maxLength size of the destination buffer
+ *
+ * @return boolean flag indicating if the key was found
+*/
+inline bool KVStore::get( const char *key, char *dest, size_t maxLength ) {
+	if( !this->file || !maxLength ) return false;
+	int slot = this->find( key, this->hash( key ) );
+	if( slot < 0 ) return false;
+
+	// read: value follows the key, find() left the file position there
+	uint32_t vallen = this->index[slot].size - KVSTORE_HEADER - strlen( key );
+	size_t len = vallen < maxLength - 1 ? vallen : maxLength - 1;
+	if( fread( dest, 1, len, this->file ) != len ) return false;
+	dest[len] = '\0';
+	return true;
+}
+
+
+/**
+ * @brief append a record to the log
+ *
+ * @param offset receives the record offset
+*/
+inline bool KVStore::append( uint8_t type, const char *key, const char *value, uint32_t *offset ) {
+	size_t keylen = strlen( key );
+	size_t vallen = value ? strlen( value ) : 0;
+	if( !keylen || keylen > KVSTORE_KEY_MAX || vallen > KVSTORE_VALUE_MAX ) return false;
+
+	uint8_t header[KVSTORE_HEADER] = { type, (uint8_t) keylen, (uint8_t)(vallen & 0xFF), (uint8_t)(vallen >> 8) };
+	uint32_t crc = this->crc32( this->crc32( this->crc32( 0, header, 4 ), (const uint8_t*) key, keylen ), (const uint8_t*) value, vallen );
+	header[4] = crc;
+	header[5] = crc >> 8;
+	header[6] = crc >> 16;
+	header[7] = crc >> 24;
+
+	// write: a failed append is truncated by the next open
+	if( fseek( this->file, this->fileSize, SEEK_SET ) != 0 ) return false;
+	bool ok = fwrite( header, 1, KVSTORE_HEADER, this->file ) == KVSTORE_HEADER
+		&& fwrite( key, 1, keylen, this->file ) == keylen
+		&& (!vallen || fwrite( value, 1, vallen, this->file ) == vallen);
+	if( ok && this->autoSync ) ok = this->sync();
+	if( !ok ) return false;
+
+	*offset = this->fileSize;
+	this->fileSize += KVSTORE_HEADER + keylen + vallen;
+	this->stats.bytesWritten += KVSTORE_HEADER + keylen + vallen;
+	this->stats.puts++;
+	return true;
+}
+
+
+/**
+ * @brief set the value of a key -- unchanged values aren't written
+ *
+ * @return boolean flag indicating if the value is stored
+*/
+inline bool KVStore::put( const char *key, const char *value ) {
+	if( !this->file ) return false;
+
+	// index: make room before appending, a record missing from the index would only be found after a reopen
+	uint32_t hash = this->hash( key );
+	if( (this->used + 1) * 4 > this->capacity * 3 && !this->grow() ) return false;
+
+	// compare: skip writing an unchanged value
+	int slot = this->find( key, hash );
+	if( slot >= 0 && this->index[slot].size == KVSTORE_HEADER + strlen(key) + strlen(value) ) {
+		char stored[KVSTORE_VALUE_MAX + 1];
+		if( this->get( key, stored, sizeof(stored) ) && strcmp( stored, value ) == 0 ) return true;
+	}
+
+	uint32_t offset;
+	if( !this->append( KVSTORE_TYPE_PUT, key, value, &offset ) ) return false;
+	if( slot >= 0 ) {
+		this->liveSize -= this->index[slot].size;
+		this->index[slot].offset = KVSTORE_SLOT_DELETED;
+		this->count--;
+	}
+	if( !this->insert( hash, offset, KVSTORE_HEADER + strlen(key) + strlen(value) ) ) return false;
+
+	if( this->fileSize > KVSTORE_COMPACT_MIN && this->fileSize > this->liveSize * KVSTORE_COMPACT_RATIO )
+		this->compact();
+	return true;
+}
+
+
+/**
+ * @brief remove a key
+ *
+ * @return boolean flag indicating if the key was removed
+*/
+inline bool KVStore::remove( const char *key ) {
+	if( !this->file ) return false;
+	int slot = this->find( key, this->hash( key ) );
+	if( slot < 0 ) return false;
+
+	uint32_t offset;
+	if( !this->append( KVSTORE_TYPE_DELETE, key, NULL, &offset ) ) return false;
+	this->liveSize -= this->index[slot].size;
+	this->index[slot].offset = KVSTORE_SLOT_DELETED;
+	this->count--;
+	return true;
+}
+
+
+/**
+ * @brief write buffered records to the sd card
+*/
+inline bool KVStore::sync() {
+	if( !this->file ) return false;
+	return fflush( this->file ) == 0 && fsync( fileno( this->file ) ) == 0;
+}
+
+
+/**
+ * @brief copy the live records into a new log and replace the old one
+ *
+ * @note the new log is written as <path>.tmp, the old log is moved to <path>.old until the new one is in place
+ *
+ * @return boolean flag indicating if the log was compacted
+*/
+inline bool KVStore::compact() {
+	if( !this->file ) return false;
+
+	char temp[sizeof(this->path) + 4];
+	char old[sizeof(this->path) + 4];
+	snprintf( temp, sizeof(temp), "%s.tmp", this->path );
+	snprintf( old, sizeof(old), "%s.old", this->path );
+
+	FILE *dest = fopen( temp, "wb" );
+	uint8_t *data = (uint8_t*) malloc( KVSTORE_HEADER + KVSTORE_KEY_MAX + KVSTORE_VALUE_MAX );
+	bool ok = dest && data && fwrite( KVSTORE_MAGIC, 1, 4, dest ) == 4;
+
+	// copy: live records in index order, the new offsets are applied after the copy succeeded
+	uint32_t *offsets = (uint32_t*) malloc( this->capacity * sizeof(uint32_t) );
+	uint32_t offset = 4;
+	ok = ok && offsets;
+	for( uint32_t i=0; ok && i < this->capacity; i++ ) {
+		Slot &slot = this->index[i];
+		if( slot.offset <= KVSTORE_SLOT_DELETED ) continue;
+		ok = fseek( this->file, slot.offset, SEEK_SET ) == 0
+			&& fread( data, 1, slot.size, this->file ) == slot.size
+			&& fwrite( data, 1, slot.size, dest ) == slot.size;
+		offsets[i] = offset;
+		offset += slot.size;
+	}
+	ok = ok && fflush( dest ) == 0 && fsync( fileno( dest ) ) == 0;
+	if( dest ) fclose( dest );
+	free( data );
+
+	// replace: old log aside, new log in place, old log removed -- open() finishes an interrupted swap
+	if( ok ) {
+		this->closeFile();
+		bool moved = rename( this->path, old ) == 0;
+		ok = moved && rename( temp, this->path ) == 0;
+		if( ok ) {
+			::remove( old );
+		} else {
+			// failed: the old log goes back in place, if that fails too open() restores it
+			if( moved ) rename( old, this->path );
+			::remove( temp );
+		}
+		this->file = fopen( this->path, "r+b" );
+		if( ok && this->file ) {
+			for( uint32_t i=0; i < this->capacity; i++ )
+				if( this->index[i].offset > KVSTORE_SLOT_DELETED ) this->index[i].offset = offsets[i];
+			this->stats.bytesWritten += offset;
+			this->stats.compactions++;
+			this->fileSize = offset;
+		} else if( this->file && !this->replay() ) {
+			this->closeFile();
+		}
+	} else {
+		::remove( temp );
+	}
+	free( offsets );
+	return ok && this->file;
+}
+
+
+/**
+ * @brief import an ini file -- keys are stored as "section/name"
+ *
+ * @return boolean flag indicating if the file was read
+*/
+inline bool KVStore::importIni( const char *path ) {
+	FILE *ini = fopen( path, "r" );
+	if( !ini || !this->file ) {
+		if( ini ) fclose( ini );
+		return false;
+	}
+
+	// parse: [section] headers and name=value lines, comments start with ';' or '#'
+	bool sync = this->autoSync;
+	this->autoSync = false;
+	char line[KVSTORE_KEY_MAX + KVSTORE_VALUE_MAX + 4];
+	char section[KVSTORE_KEY_MAX + 1] = "";
+	char key[KVSTORE_KEY_MAX + 1];
+	while( fgets( line, sizeof(line), ini ) ) {
+		char *text = line;
+		while( isspace( *text ) ) text++;
+		char *end = text + strlen( text );
+		while( end > text && isspace( end[-1] ) ) *--end = '\0';
+		if( !*text || *text == ';' || *text == '#' ) continue;
+
+		if( *text == '[' && end[-1] == ']' ) {
+			end[-1] = '\0';
+			strncpy( section, text + 1, KVSTORE_KEY_MAX );
+			section[KVSTORE_KEY_MAX] = '\0';
+			continue;
+		}
+
+		char *value = strchr( text, '=' );
+		if( !value ) continue;
+		char *name_end = value;
+		*value++ = '\0';
+		while( name_end > text && isspace( name_end[-1] ) ) *--name_end = '\0';
+		while( isspace( *value ) ) value++;
+		if( snprintf( key, sizeof(key), "%s%s%s", section, *section ? "/" : "", text ) < (int) sizeof(key) )
+			this->put( key, value );
+	}
+	fclose( ini );
+	this->autoSync = sync;
+	return this->sync();
+}
+
+
+/**
+ * @brief export the store as ini file -- keys are grouped by the section before the first '/'
+ *
+ * @return boolean flag indicating if the file was written
+*/
+inline bool KVStore::exportIni( const char *path ) {
+	if( !this->file ) return false;
+
+	// load: live records sorted by key so sections are written together, keys without a section first
+	char **entries = (char**) calloc( this->count + 1, sizeof(char*) );
+	uint32_t n = 0;
+	for( uint32_t i=0; entries && i < this->capacity && n < this->count; i++ ) {
+		Slot &slot = this->index[i];
+		if( slot.offset <= KVSTORE_SLOT_DELETED ) continue;
+		char *entry = (char*) malloc( slot.size - KVSTORE_HEADER + 2 );
+		if( !entry || !this->readKey( slot.offset, entry ) ) {
+			free( entry );
+			continue;
+		}
+		size_t keylen = strlen( entry );
+		size_t vallen = slot.size - KVSTORE_HEADER - keylen;
+		entry[keylen + 1 + fread( entry + keylen + 1, 1, vallen, this->file )] = '\0';
+		entries[n++] = entry;
+	}
+	qsort( entries, n, sizeof(char*), []( const void *a, const void *b ) {
+		const char *x = *(char* const*) a;
+		const char *y = *(char* const*) b;
+		bool sx = strchr( x, '/' ) != NULL;
+		bool sy = strchr( y, '/' ) != NULL;
+		return sx != sy ? sx - sy : strcmp( x, y );
+	});
+
+	FILE *ini = entries ? fopen( path, "w" ) : NULL;
+	char section[KVSTORE_KEY_MAX + 1] = "";
+	for( uint32_t i=0; ini && i < n; i++ ) {
+		char *name = strchr( entries[i], '/' );
+		name = name ? name + 1 : entries[i];
+		size_t len = name > entries[i] ? name - entries[i] - 1 : 0;
+		if( i == 0 || strlen( section ) != len || strncmp( section, entries[i], len ) != 0 ) {
+			memcpy( section, entries[i], len );
+			section[len] = '\0';
+			if( len ) fprintf( ini, "%s[%s]\n", i ? "\n" : "", section );
+		}
+		fprintf( ini, "%s=%s\n", name, name + strlen( name ) + 1 );
+	}
+
+	for( uint32_t i=0; i < n; i++ ) free( entries[i] );
+	free( entries );
+	return ini && fclose( ini ) == 0;
+}
+
+/*
+	Close the 'PocuterUtil' namespace
+*/
+};
+
+// undefine internal macros and constants
+#undef KVSTORE_TYPE_PUT
+#undef KVSTORE_TYPE_DELETE
+#undef KVSTORE_SLOT_EMPTY
+#undef KVSTORE_SLOT_DELETED
+#undef KVSTORE_INDEX_MIN
+
+#endif // _POCUTERUTIL_KVSTORE_H_
@@ -14,16 +14,41 @@
 
 #include <Pocuter.h>
 #include <cstring>
+#include "KeyboardDict.h"
+#include "KeyboardGap.h"
+#include "KeyboardOrder.h"
 
 // local: max length constraints
 #define KEYSET_WIDTH_MAX    12
 #define KEYSET_STRING_MAX   255
 #define KEYSET_BLINK_LEN    250
 
+// local: keyboard layout -- text row, key column, and 5x7 font cell size
+#define KEYSET_TEXT_Y       32
+#define KEYSET_KEYS_Y       14
+#define KEYSET_KEYS_PITCH   9
+#define KEYSET_CELL_W       6
+#define KEYSET_CELL_H       8
+
+// local: editing mode layout -- characters left of the key column, cursor margin, and key width in the text row
+#define KEYSET_EDIT_WIDTH   8
+#define KEYSET_EDIT_MARGIN  2
+#define KEYSET_EDIT_SLOT    4
+
 // local: special format keys
 #define KBD_CHAR_SPACE   ' '
 #define KBD_CHAR_DELETE  '\r'
 #define KBD_CHAR_RETURN  '\n'
+#define KBD_CHAR_WORD    '\x01'  // first completion candidate key
+#define KBD_CHAR_LEFT    '\x04'  // editing mode: cursor left key
+#define KBD_CHAR_RIGHT   '\x05'  // editing mode: cursor right key
+
+// local: characters that end a word -- dictionary completion looks up the current word, for example a hostname segment
+#define KEYSET_WORD_BREAK   " .,;:/\\@-_"
+
+// global: completion candidate keys and history size
+#define KEYBOARD_CANDIDATES   3   /**< completion candidate keys */
+#define KEYBOARD_HISTORY      4   /**< most recently used entries stored with the binding */
 
 // global: character set primitive strings
 #define CHARSET_NONE     "\r\n"
@@ -39,6 +64,9 @@
 #define CHARSET_HOSTNAME CHARSET_LOWER CHARSET_NUMERIC "-."
 #define CHARSET_HEX      CHARSET_NUMERIC "ABCDEF"
 
+// local: text buffer slack for the float '0.' prefix and ip address '.' auto-formatting
+#define KEYSET_TEXT_PAD     2
+
 // global: key set primitive bit-flags
 #define KEYSET_CUSTOM    0x0000 /**< keyset flag: user-defined */
 #define KEYSET_UPPER     0x0001 /**< keyset flag: upper-case letters */
@@ -52,11 +80,29 @@
 #define KEYSET_HOSTNAME  0x0100 /**< keyset flag: hostname */
 #define KEYSET_IPADDR    0x0200 /**< keyset flag: ip-address */
 
+// global: key order bit-flags, see tools/order-keys
+#define KEYSET_ORDERED   0x0400 /**< keyset flag: keys ordered for fewer button presses */
+#define KEYSET_HOME      0x0800 /**< keyset flag: cursor returns to the first key after each character */
+
 // global: key set complex bit-flags
 #define KEYSET_ALPHA            KEYSET_UPPER | KEYSET_LOWER   /**< keyset flag: upper+lower letters */
 #define KEYSET_ALPHA_NUMERIC    KEYSET_ALPHA | KEYSET_NUMERIC /**< keyset flag: upper+lower+numeric characters */
 #define KEYSET_FULL             KEYSET_ALPHA_NUMERIC | KEYSET_SYMBOLS | KEYSET_SPACE /**< keyset flag: upper+lower+numeric+symbols+space characters */
 
+// local: compose a key set string from primitive flag bits at compile time -- the table holds
+// every combination of the composable flags, each prefixed by the negative sign which is skipped
+// unless KEYSET_NEGATIVE is set, so the strings can live in flash without per-instance copies
+#define KEYSET_PICK_0(chars)
+#define KEYSET_PICK_1(chars)             chars
+#define KEYSET_CHARS(sp,sy,nu,lo,up)     "-" KEYSET_PICK_##up(CHARSET_UPPER) KEYSET_PICK_##lo(CHARSET_LOWER) \
+                                         KEYSET_PICK_##nu(CHARSET_NUMERIC) KEYSET_PICK_##sy(CHARSET_SYMBOLS) \
+                                         KEYSET_PICK_##sp(CHARSET_SPACE) CHARSET_NONE
+#define KEYSET_CHARS_4(sp,sy,nu)         KEYSET_CHARS(sp,sy,nu,0,0), KEYSET_CHARS(sp,sy,nu,0,1), \
+                                         KEYSET_CHARS(sp,sy,nu,1,0), KEYSET_CHARS(sp,sy,nu,1,1)
+#define KEYSET_CHARS_16(sp)              KEYSET_CHARS_4(sp,0,0), KEYSET_CHARS_4(sp,0,1), \
+                                         KEYSET_CHARS_4(sp,1,0), KEYSET_CHARS_4(sp,1,1)
+#define KEYSET_COMPOSABLE                0x001F
+
 // local: button input macros
 #define ACTION_HOLD_A (getInput(BUTTON_A) & HOLD)
 #define ACTION_HOLD_B (getInput(BUTTON_B) & HOLD)
@@ -66,11 +112,90 @@
 #define COLOR_BRIGHTER(c)   (c | 0x00808080)
 #define COLOR_DARKER(c)     (c & 0x003F3F3F)
 
+// local: trace markers -- no-ops when the BaseApp template has no trace recorder
+#ifndef TRACE_SCOPE
+#define KEYBOARD_TRACE_STUBS
+#define TRACE_SCOPE(name)
+#define TRACE_INSTANT(name)
+#endif
+
 // ------------------------------------------------------------------------------------------------
 //
 //	Use the 'PocuterUtil' namespace
 //
 namespace PocuterUtil {
+
+// key set strings indexed by the composable flag bits -- UPPER, LOWER, NUMERIC, SYMBOLS, SPACE
+static constexpr const char* const keysetTable[ KEYSET_COMPOSABLE + 1 ] = {
+	KEYSET_CHARS_16(0), KEYSET_CHARS_16(1)
+};
+
+// special mode key set strings, also prefixed by the negative sign
+static constexpr const char* keysetIPAddr   = "-" CHARSET_IPADDR CHARSET_NONE;
+static constexpr const char* keysetHostname = "-" CHARSET_HOSTNAME CHARSET_NONE;
+static constexpr const char* keysetHex      = "-" CHARSET_HEX CHARSET_NONE;
+static constexpr const char* keysetFloat    = "-" CHARSET_FLOAT CHARSET_NONE;
+
+/**
+* @brief get the special mode key set string in the default or the optimized order
+*
+* @param chars default key set string
+* @param index special mode of the KeyboardOrder.h tables: ip address, hostname, hex, float
+*/
+constexpr const char* keysetSpecial( uint16_t keyset, const char *chars, int index ) {
+	return
+		!(keyset & KEYSET_ORDERED) ? chars :
+		(keyset & KEYSET_HOME)     ? keysetOrderHomeSpecial[ index ] :
+		keysetOrderStaySpecial[ index ];
+}
+
+/**
+* @brief get the composable key set string in the default or the optimized order
+*/
+constexpr const char* keysetComposable( uint16_t keyset ) {
+	return
+		!(keyset & KEYSET_ORDERED) ? keysetTable[ keyset & KEYSET_COMPOSABLE ] :
+		(keyset & KEYSET_HOME)     ? keysetOrderHome[ keyset & KEYSET_COMPOSABLE ] :
+		keysetOrderStay[ keyset & KEYSET_COMPOSABLE ];
+}
+
+/**
+* @brief get the built-in character set of a key set
+*
+* @note evaluated at compile time for constant key sets, see KeyboardT
+*
+* @param keyset character set bit flags
+*
+* @return character set string in flash, terminated by the DELETE and RETURN keys
+*/
+constexpr const char* keysetCharset( uint16_t keyset ) {
+	return
+		(keyset & KEYSET_IPADDR)   ? keysetSpecial( keyset, keysetIPAddr, 0 ) + 1 :
+		(keyset & KEYSET_HOSTNAME) ? keysetSpecial( keyset, keysetHostname, 1 ) + 1 :
+		(keyset & KEYSET_HEX)      ? keysetSpecial( keyset, keysetHex, 2 ) + !(keyset & KEYSET_NEGATIVE) :
+		(keyset & KEYSET_FLOAT)    ? keysetSpecial( keyset, keysetFloat, 3 ) + !(keyset & KEYSET_NEGATIVE) :
+		keysetComposable( keyset ) + !(keyset & KEYSET_NEGATIVE);
+}
+
+/**
+* @brief PocuterUtil::KeyboardStats -- Keyboard draw statistics
+*/
+struct KeyboardStats {
+	uint32_t frames;  /**< calls to getchar() */
+	uint32_t draws;   /**< frames that changed the display */
+	uint32_t pixels;  /**< pixels written by fill and text draw calls */
+	uint32_t micros;  /**< time spent drawing */
+};
+
+/**
+* @brief PocuterUtil::KeyboardCompletion -- Completion candidate storage, allocated by Keyboard::complete()
+*/
+struct KeyboardCompletion {
+	char words[ KEYBOARD_CANDIDATES ][ KEYBOARD_DICT_WORD_MAX + 1 ];  /**< dictionary lookup results */
+	const char *list[ KEYBOARD_CANDIDATES ];                          /**< candidate texts */
+	uint start[ KEYBOARD_CANDIDATES ];                                /**< text position replaced by each candidate */
+};
+
 /**
 * @brief PocuterUtil::Keyboard -- Pocuter Utility Class for Flexible Keyboard Input
 *  
@@ -82,42 +207,99 @@ class Keyboard {
 		// Pocuter system object
 		Pocuter *pocuter;
 
-		// Pocuter configuration bindings
+		// Pocuter configuration bindings -- the settings cache of the BaseApp template is used when included before the keyboard
 		PocuterConfig *binding;
+		char *configFile;
 		uint8_t *configSection;
 		uint8_t *configName;
 
+		bool configGet( const char *name, char *dest, size_t maxLength );
+		bool configSet( const char *name, const char *value );
+
 		// keyboard label
 		char label[17];
 
 		// keyboard key set+mode flags
 		uint16_t keyset;
 
-		// keyboard text buffer and max-length
-		char text[ KEYSET_STRING_MAX + 1 ];
+		// keyboard text buffer and max-length -- allocated unless provided by KeyboardT, empty fallback when the allocation failed
+		char *text;
+		char *textBuffer;
+		char textEmpty[ 1 + KEYSET_TEXT_PAD ];
 		uint maxlen;
 
-		// keyboard character set and cursor position
-		char charset[ KEYSET_STRING_MAX + 3 ];
+		// keyboard character set and cursor position -- built-in key sets point to flash
+		const char *charset;
+		char *customCharset;
 		int cursor;
 
 		// auto-scroll state flag
 		bool scrolling;
 
+		// editing mode: gap buffer over the text buffer, and first visible character of the text
+		KeyboardGap gap;
+		bool editing;
+		uint viewStart;
+
+		// completion: dictionary, bound history, and candidate keys appended after the character set -- allocated by complete()
+		KeyboardDict *dict;
+		bool history;
+		char *historyText;
+		uint historyCount;
+		KeyboardCompletion *completion;
+		uint candidateCount;
+		int candidateTextlen;
+		int charlen;
+
 		// selected chararcter blink state
 		unsigned long lastFrame;
 		unsigned long interval;
 		bool blinking;
+
+		// last rendered frame -- only the changed parts are redrawn
+		bool drawn;
+		uint drawnTextlen;
+		uint drawnPoint;
+		int drawnTextpos;
+		int drawnCursor;
+		bool drawnBlink;
+		bool drawnLimit;
+		UG_COLOR drawnColor;
+
+		void drawFill( UGUI *gui, int x1, int y1, int x2, int y2 );
+		void drawText( UGUI *gui, int x, int y, const char *str );
+		void drawKey( UGUI *gui, int x, int i, char key, UG_COLOR color );
+		void drawKeys( UGUI *gui, int x, int setlen, bool limit, bool blinkOnly );
+		void drawTail( UGUI *gui, int x, int width, uint point );
+
+		char keyAt( int index );
+		char limitKey( int index );
+		void addCandidate( const char *word, uint start, uint textlen );
+		void updateCandidates( uint textlen );
+		void loadHistory();
+		void saveHistory();
+
+	protected:
+		Keyboard( Pocuter *pocuter, char *label, uint keyset, uint maxlen, char *buffer, const char *charset );
+		bool init( Pocuter *pocuter, char *label, uint keyset, uint maxlen, char *buffer, const char *charset );
 		
 	public:
+		bool ready;       /**< flag: text buffer allocated */
 		bool active;      /**< flag: keyboard 'in-use' */
 		bool autoupdate;  /**< flag: auto-update display */
+		bool updated;     /**< flag: display changed by the last getchar() */
 
 		UG_COLOR color;   /**< display text color */
 
+		KeyboardStats stats;  /**< draw statistics */
+
 		Keyboard( Pocuter *pocuter, char *label, uint keyset, uint maxlen );
+		Keyboard( const Keyboard& ) = delete;
+		Keyboard& operator=( const Keyboard& ) = delete;
+		virtual ~Keyboard();
 		
-		void custom( char *charset );
+		bool custom( char *charset );
+		void edit( char *buffer, uint maxlen );
 
 		void clear();
 		void set( char *newtext );
@@ -128,7 +310,10 @@ class Keyboard {
 		bool load();
 		bool save();
 
+		bool complete( KeyboardDict *dict, bool history );
+
 		bool getchar();
+		void redraw();
 };
 /**
  * @brief Keyboard Constructor
@@ -139,97 +324,100 @@ class Keyboard {
  * @param maxlen maximum length of keyboard text, must be <= 255
 */
 Keyboard::Keyboard( Pocuter *pocuter, char *label, uint keyset = KEYSET_FULL, uint maxlen = 0 ) {
+	this->init( pocuter, label, keyset, maxlen, NULL, keysetCharset( keyset ) );
+}
+
+/**
+ * @brief Keyboard Constructor with caller provided text buffer and character set, see KeyboardT
+ * 
+ * @param buffer text buffer of at least maxlen + 3 bytes
+ * @param charset built-in character set of the key set
+*/
+Keyboard::Keyboard( Pocuter *pocuter, char *label, uint keyset, uint maxlen, char *buffer, const char *charset ) {
+	this->init( pocuter, label, keyset, maxlen, buffer, charset );
+}
+
+/**
+ * @brief Keyboard Destructor
+*/
+Keyboard::~Keyboard() {
+	if( this->binding ) delete this->binding;
+	free( this->textBuffer );
+	free( this->customCharset );
+	free( this->historyText );
+	free( this->completion );
+}
+
+/**
+ * @brief initialize keyboard state
+ * 
+ * @note a failed text buffer allocation leaves an empty keyboard with a max length of zero, the ready flag is cleared
+ * 
+ * @return boolean flag indicating if the text buffer was allocated
+*/
+bool Keyboard::init( Pocuter *pocuter, char *label, uint keyset, uint maxlen, char *buffer, const char *charset ) {
 	
 	// save reference to pocuter object
 	this->pocuter = pocuter;
 
 	// zero binding pointers
 	this->binding = NULL;
-	this->configSection - NULL;
+	this->configFile = NULL;
+	this->configSection = NULL;
 	this->configName = NULL;
 
-	// zero buffer memory
-	memset( this->label,   0, 17 );
-	memset( this->text,    0, KEYSET_STRING_MAX + 1);
-	memset( this->charset, 0, KEYSET_STRING_MAX + 3);
-
 	// copy label string text
+	memset( this->label, 0, 17 );
 	strncpy( this->label, label, 16 );
 	
 	// set default display color to default system color
 	this->color = C_LIME;
 
-	// validate max text length
+	// validate max text length, ip addresses are limited to 15 characters
 	if( maxlen > KEYSET_STRING_MAX ) maxlen = KEYSET_STRING_MAX;
+	if( !maxlen ) maxlen = KEYSET_STRING_MAX;
+	if( (keyset & KEYSET_IPADDR) && (!buffer || maxlen > 15) ) maxlen = 15;
 
 	// init state variables
 	this->active = false;
-	this->maxlen = maxlen ? maxlen : KEYSET_STRING_MAX;
+	this->maxlen = maxlen;
 	this->cursor = 0;
 	this->autoupdate = true;
 	this->scrolling = false;
+	this->editing = false;
+	this->viewStart = 0;
 	this->lastFrame = micros();
 	this->interval = 0;
 	this->blinking = false;
-
-	// save keyset code
+	this->drawn = false;
+	this->drawnTextpos = 0;
+	this->drawnPoint = 0;
+	this->updated = false;
+	this->dict = NULL;
+	this->history = false;
+	this->historyText = NULL;
+	this->historyCount = 0;
+	this->completion = NULL;
+	this->candidateCount = 0;
+	this->candidateTextlen = -1;
+	this->charlen = 0;
+	memset( &this->stats, 0, sizeof(KeyboardStats) );
+
+	// save keyset code and built-in character set
 	this->keyset = keyset;
-
-	// custom keyset only assign end-control characters
-	if( keyset == KEYSET_CUSTOM ) {
-		strcpy( this->charset, CHARSET_NONE);
-		return;
+	this->charset = charset;
+	this->customCharset = NULL;
+
+	// text buffer sized by max length
+	this->textBuffer = buffer ? NULL : (char*) malloc( maxlen + 1 + KEYSET_TEXT_PAD );
+	this->text = buffer ? buffer : this->textBuffer;
+	this->ready = this->text != NULL;
+	if( !this->ready ) {
+		this->text = this->textEmpty;
+		this->maxlen = 0;
 	}
-
-	// assign special ip address charset (return)
-	if( keyset & KEYSET_IPADDR ) {
-		strcpy( this->charset, CHARSET_IPADDR CHARSET_NONE );
-		this->maxlen = 15;
-		return;
-	}
-
-	// assign special hostname charset (return)
-	if( keyset & KEYSET_HOSTNAME ) {
-		strcpy( this->charset, CHARSET_HOSTNAME CHARSET_NONE );
-		return;
-	}
-
-	// prepend negative sign to numeric types (fall-through)
-	if( keyset & KEYSET_NEGATIVE ) {
-		strcpy( this->charset, "-" );
-	}
-
-	// assign special hexadecimal charset (return)
-	if( keyset & KEYSET_HEX ) {
-		strcat( this->charset, CHARSET_HEX CHARSET_NONE );
-		return;
-	}
-
-	// assign special float charset (return)
-	if( keyset & KEYSET_FLOAT ) {
-		strcat( this->charset, CHARSET_FLOAT CHARSET_NONE );
-		return;
-	}
-
-	// compose character set from keyset bit flags
-	if( keyset & KEYSET_UPPER )
-		strcat( this->charset, CHARSET_UPPER );
-
-	if( keyset & KEYSET_LOWER )
-		strcat( this->charset, CHARSET_LOWER );
-
-	if( keyset & KEYSET_NUMERIC )
-		strcat( this->charset, CHARSET_NUMERIC );
-
-	if( keyset & KEYSET_SYMBOLS )
-		strcat( this->charset, CHARSET_SYMBOLS );
-
-	if( keyset & KEYSET_SPACE )
-		strcat( this->charset, " " );
-
-
-	// append end-control characters to charset
-	strcat( this->charset, CHARSET_NONE);
+	memset( this->text, 0, this->maxlen + 1 + KEYSET_TEXT_PAD );
+	return this->ready;
 }
 
 
@@ -240,13 +428,62 @@ Keyboard::Keyboard( Pocuter *pocuter, char *label, uint keyset = KEYSET_FULL, ui
  * 
  * @param charset string containing allowed keyboard characters
  * 
+ * @return boolean flag indicating if the character set was allocated, the current key set is kept otherwise
 */
-void Keyboard::custom( char *charset ) {
+bool Keyboard::custom( char *charset ) {
+	size_t len = strnlen( charset, KEYSET_STRING_MAX );
+	char *copy = (char*) calloc( 1, len + 3 );
+	if( !copy ) return false;
 	this->keyset = KEYSET_CUSTOM;
-	memset( this->charset, 0, KEYSET_STRING_MAX + 3 );
-	strncpy( this->charset, charset, KEYSET_STRING_MAX );
-	strcat( this->charset, CHARSET_NONE );
+	free( this->customCharset );
+	this->customCharset = copy;
+	memcpy( this->customCharset, charset, len );
+	strcat( this->customCharset, CHARSET_NONE );
+	this->charset = this->customCharset;
 	this->cursor = 0;
+	this->drawn = false;
+	this->candidateTextlen = -1;
+	return true;
+}
+
+
+/**
+ * @brief enable the editing mode -- cursor keys, insert and delete at the cursor, and a text view that follows the cursor
+ * 
+ * @note the text is kept and the cursor is placed at its end
+ * @note the formatting rules of the special input modes apply while typing at the end of the text
+ * 
+ * @param buffer text buffer of at least maxlen + 3 bytes, NULL keeps the current buffer and max length
+ * @param maxlen maximum length of keyboard text, not limited to 255 characters
+*/
+void Keyboard::edit( char *buffer = NULL, uint maxlen = 0 ) {
+	if( buffer && maxlen ) {
+
+		// move: current text into the new buffer
+		const char *current = this->get();
+		uint len = strnlen( current, maxlen );
+		memmove( buffer, current, len );
+		buffer[ len ] = '\0';
+		free( this->textBuffer );
+		this->textBuffer = NULL;
+		this->text = buffer;
+		this->maxlen = maxlen;
+		this->ready = true;
+
+		// history entries are sized by the max length
+		if( this->historyText ) {
+			free( this->historyText );
+			this->historyText = NULL;
+			this->complete( this->dict, true );
+		}
+	}
+
+	this->editing = true;
+	this->gap.init( this->text, this->maxlen + KEYSET_TEXT_PAD );
+	this->gap.reset( strnlen( this->text, this->maxlen ) );
+	this->viewStart = 0;
+	this->drawn = false;
+	this->candidateTextlen = -1;
 }
 
 
@@ -266,18 +503,25 @@ void Keyboard::clear() {
  * @note resets keyboard cursor position
 */
 void Keyboard::set( char *newtext ) {
-	memset( this->text, 0, KEYSET_STRING_MAX + 1 );
+	memset( this->text, 0, this->maxlen + 1 );
 	strncpy( this->text, newtext, this->maxlen );
+	if( this->editing ) this->gap.reset( strlen( this->text ) );
+	this->viewStart = 0;
 	this->cursor = strlen(this->charset) - 1;
+	this->drawn = false;
+	this->candidateTextlen = -1;
 }
 
 
 /**
  * @brief get keyboard text buffer
  * 
+ * @note in editing mode the text is made contiguous first, the cursor is kept
+ * 
  * @return pointer to keyboard text
 */
 char* Keyboard::get() {
+	if( this->editing ) this->gap.text();
 	return this->text;
 }
 
@@ -314,13 +558,18 @@ bool Keyboard::bind( char *section, char *name, bool autoload = false ) {
 */
 bool Keyboard::bind( char *configName, char *section, char *name, bool autoload = false ) {
 	if( this->binding ) delete binding;
+	this->binding = NULL;
+	this->configFile = NULL;
 
 	// verify that valid configName, section, and name have been provided
 	if( !(configName && strlen(configName) && section && strlen(section) && name && strlen(name)) )
 		return false;
 
-	// create configuration object and store section+name pointers
+	// create configuration object unless the shared settings cache is available, store file+section+name pointers
+#ifndef SETTINGS_FILE
 	this->binding = new PocuterConfig((const uint8_t *) configName );
+#endif
+	this->configFile = configName;
 	this->configSection = (uint8_t*) section;
 	this->configName = (uint8_t*) name;
 	
@@ -331,6 +580,33 @@ bool Keyboard::bind( char *configName, char *section, char *name, bool autoload
 	return true;
 }
 
+/**
+ * @brief read a setting of the bound configuration section
+ * 
+ * @return boolean flag indicating if the setting exists
+*/
+bool Keyboard::configGet( const char *name, char *dest, size_t maxLength ) {
+#ifdef SETTINGS_FILE
+	return getConfigSetting( this->configFile, (char*) this->configSection, name, dest, maxLength );
+#else
+	return this->binding->get( this->configSection, (const uint8_t*) name, (uint8_t*) dest, maxLength );
+#endif
+}
+
+/**
+ * @brief write a setting of the bound configuration section
+ * 
+ * @return boolean flag indicating if the setting was written
+*/
+bool Keyboard::configSet( const char *name, const char *value ) {
+#ifdef SETTINGS_FILE
+	return setConfigSetting( this->configFile, (char*) this->configSection, name, value );
+#else
+	return this->binding->set( this->configSection, (const uint8_t*) name, (const uint8_t*) value );
+#endif
+}
+
+
 /**
  * @brief load the bound configuration setting into the keyboard buffer
  * 
@@ -339,10 +615,12 @@ bool Keyboard::bind( char *configName, char *section, char *name, bool autoload
  * @return boolean flag indiciating if a value was loaded
 */
 bool Keyboard::load() {
-	if( !this->binding || !pocuter->SDCard->cardIsMounted() ) return false;
+	if( !this->configFile || !pocuter->SDCard->cardIsMounted() ) return false;
 
 	this->clear();
-	this->binding->get( this->configSection, this->configName, (uint8_t*) this->text, this->maxlen );
+	this->configGet( (char*) this->configName, this->text, this->maxlen + 1 );
+	if( this->editing ) this->gap.reset( strlen( this->text ) );
+	if( this->history ) this->loadHistory();
 	return( strlen(this->text) > 0 );
 }
 
@@ -354,21 +632,313 @@ bool Keyboard::load() {
  * @return boolean flag indiciating if a value was saved
 */
 bool Keyboard::save() {
-	if( !this->binding || !pocuter->SDCard->cardIsMounted() ) return false;
-	this->binding->set( this->configSection, this->configName, (uint8_t*) this->text );
+	if( !this->configFile || !pocuter->SDCard->cardIsMounted() ) return false;
+	bool saved = this->configSet( (char*) this->configName, this->get() );
+	if( this->history ) this->saveHistory();
+	return saved;
+}
+
+
+/**
+ * @brief enable word completion candidate keys
+ * 
+ * @note candidates are shown as extra keys after the [OK] key, selecting one replaces the keyboard text
+ * @note history entries are stored with the bound configuration setting as <name>_mru0 ... <name>_mru3 by save()
+ * @note the candidate and history storage is allocated here and released when completion is disabled
+ * 
+ * @param dict completion dictionary, NULL for history only
+ * @param history offer the most recently saved entries of the bound setting first
+ * 
+ * @return boolean flag indicating if completion is enabled, false when disabled or the storage could not be allocated
+*/
+bool Keyboard::complete( KeyboardDict *dict, bool history = true ) {
+	this->dict = dict;
+	this->history = history;
+	this->candidateCount = 0;
+	this->candidateTextlen = -1;
+	this->drawn = false;
+
+	if( history && !this->historyText ) {
+		this->historyText = (char*) calloc( KEYBOARD_HISTORY, this->maxlen + 1 );
+		this->history = this->historyText != NULL;
+	}
+	if( (dict || this->history) && !this->completion )
+		this->completion = (KeyboardCompletion*) malloc( sizeof(KeyboardCompletion) );
+
+	// disabled, or out of memory: release the storage
+	if( !this->completion || !(dict || this->history) ) {
+		free( this->historyText );
+		free( this->completion );
+		this->historyText = NULL;
+		this->completion = NULL;
+		this->dict = NULL;
+		this->history = false;
+		this->historyCount = 0;
+		return false;
+	}
+
+	if( this->history ) this->loadHistory();
 	return true;
 }
 
 
+/**
+ * @brief load the history entries of the bound configuration setting
+*/
+void Keyboard::loadHistory() {
+	this->historyCount = 0;
+	this->candidateTextlen = -1;
+	if( !this->configFile || !pocuter->SDCard->cardIsMounted() ) return;
+
+	char key[64];
+	for( uint i=0; i < KEYBOARD_HISTORY; i++ ) {
+		char *entry = this->historyText + this->historyCount * (this->maxlen + 1);
+		snprintf( key, sizeof(key), "%s_mru%u", (char*) this->configName, i );
+		memset( entry, 0, this->maxlen + 1 );
+		this->configGet( key, entry, this->maxlen + 1 );
+		if( strlen(entry) ) this->historyCount++;
+	}
+}
+
+
+/**
+ * @brief move the keyboard text to the front of the history and store the history entries
+*/
+void Keyboard::saveHistory() {
+	if( !strlen(this->text) ) return;
+	uint size = this->maxlen + 1;
+
+	// remove: existing copy of the text, or the oldest entry when the history is full
+	uint i = 0;
+	while( i < this->historyCount && strcmp( this->historyText + i * size, this->text ) != 0 ) i++;
+	if( i == KEYBOARD_HISTORY ) i--;
+	else if( i == this->historyCount ) this->historyCount++;
+
+	// insert: text as most recent entry
+	memmove( this->historyText + size, this->historyText, i * size );
+	strncpy( this->historyText, this->text, this->maxlen );
+
+	char key[64];
+	for( i=0; i < this->historyCount; i++ ) {
+		snprintf( key, sizeof(key), "%s_mru%u", (char*) this->configName, i );
+		this->configSet( key, this->historyText + i * size );
+	}
+	this->candidateTextlen = -1;
+}
+
+
+/**
+ * @brief get key of the character set or candidate key
+ * 
+ * @param index key index, the cursor keys of the editing mode and the candidate keys follow the character set
+ * 
+ * @return key character, or cursor and candidate key code
+*/
+char Keyboard::keyAt( int index ) {
+	if( index < this->charlen ) return this->charset[ index ];
+	index -= this->charlen;
+	if( this->editing ) {
+		if( index < 2 ) return KBD_CHAR_LEFT + index;
+		index -= 2;
+	}
+	return KBD_CHAR_WORD + index;
+}
+
+
+/**
+ * @brief get key shown when the max length is reached
+ * 
+ * @param index key index: DELETE, RETURN, and the cursor keys of the editing mode
+*/
+char Keyboard::limitKey( int index ) {
+	static const char keys[] = { KBD_CHAR_DELETE, KBD_CHAR_RETURN, KBD_CHAR_LEFT, KBD_CHAR_RIGHT };
+	return keys[ index ];
+}
+
+
+/**
+ * @brief add completion candidate -- must extend the text, fit the max length, and only use characters of the key set
+ * 
+ * @param word candidate replacing the text from start, starts with the text from start
+ * @param start text position replaced by the candidate
+ * @param textlen text length
+*/
+void Keyboard::addCandidate( const char *word, uint start, uint textlen ) {
+	if( this->candidateCount == KEYBOARD_CANDIDATES ) return;
+	uint prefix = textlen - start;
+	if( strlen(word) <= prefix || start + strlen(word) > this->maxlen ) return;
+	for( const char *c = word + prefix; *c; c++ )
+		if( !strchr( this->charset, *c ) ) return;
+
+	// duplicate: the completed parts are appended to the same text
+	for( uint i=0; i < this->candidateCount; i++ )
+		if( strcmp( this->completion->list[i] + textlen - this->completion->start[i], word + prefix ) == 0 ) return;
+	this->completion->start[ this->candidateCount ] = start;
+	this->completion->list[ this->candidateCount++ ] = word;
+}
+
+
+/**
+ * @brief update completion candidates for the current text -- history entries first, then dictionary words
+ * 
+ * @note history entries complete the whole text, dictionary words complete the current word after the last word break
+*/
+void Keyboard::updateCandidates( uint textlen ) {
+	this->candidateCount = 0;
+	this->candidateTextlen = textlen;
+
+	for( uint i=0; i < this->historyCount; i++ ) {
+		const char *entry = this->historyText + i * (this->maxlen + 1);
+		if( strncmp( entry, this->text, textlen ) == 0 ) this->addCandidate( entry, 0, textlen );
+	}
+
+	if( this->dict && this->candidateCount < KEYBOARD_CANDIDATES ) {
+		uint start = textlen;
+		while( start && !strchr( KEYSET_WORD_BREAK, this->text[ start - 1 ] ) ) start--;
+		if( textlen - start > KEYBOARD_DICT_WORD_MAX ) return;
+		int count = this->dict->lookup( this->text + start, this->completion->words, KEYBOARD_CANDIDATES );
+		for( int i=0; i < count; i++ ) this->addCandidate( this->completion->words[i], start, textlen );
+	}
+}
+
+
+/**
+ * @brief redraw the whole keyboard on the next call to getchar()
+ * 
+ * @note call this after drawing over the keyboard or modifying the text buffer returned by get()
+*/
+void Keyboard::redraw() {
+	this->drawn = false;
+}
+
+
+/**
+ * @brief fill display area and count written pixels
+*/
+void Keyboard::drawFill( UGUI *gui, int x1, int y1, int x2, int y2 ) {
+	if( x2 < x1 || y2 < y1 ) return;
+	gui->UG_FillFrame( x1, y1, x2, y2, C_BLACK );
+	this->stats.pixels += (x2 - x1 + 1) * (y2 - y1 + 1);
+}
+
+
+/**
+ * @brief draw text string and count written pixels
+*/
+void Keyboard::drawText( UGUI *gui, int x, int y, const char *str ) {
+	gui->UG_PutStringSingleLine( x, y, str );
+	this->stats.pixels += strlen( str ) * KEYSET_CELL_W * KEYSET_CELL_H;
+}
+
+
+/**
+ * @brief draw a single key of the keyboard character set column
+ * 
+ * @param x left edge of the key column
+ * @param i key row, the selected key is row 2
+ * @param key keyset character
+ * @param color key text color
+*/
+void Keyboard::drawKey( UGUI *gui, int x, int i, char key, UG_COLOR color ) {
+	char letter[ KEYSET_WIDTH_MAX + 2 ];
+
+	// format completion candidate keys: '+' and the completed part of the word, truncated to screen width
+	if( key >= KBD_CHAR_WORD && key < KBD_CHAR_WORD + KEYBOARD_CANDIDATES ) {
+		uint16_t sizeX;
+		uint16_t sizeY;
+		pocuter->Display->getDisplaySize(sizeX, sizeY);
+		int width = (sizeX - x) / KEYSET_CELL_W - 1;
+		if( width > KEYSET_WIDTH_MAX ) width = KEYSET_WIDTH_MAX;
+		if( width < 1 ) width = 1;
+		letter[0] = '+';
+		int k = key - KBD_CHAR_WORD;
+		strncpy( letter + 1, this->completion->list[k] + this->candidateTextlen - this->completion->start[k], width );
+		letter[ width + 1 ] = '\0';
+	}
+
+	// format keyboard 'action' characters 
+	else if( key == KBD_CHAR_RETURN ) { strcpy(letter,"[OK]"); }
+	else if( key == KBD_CHAR_SPACE ) { strcpy(letter,"[ ]"); }
+	else if( key == KBD_CHAR_DELETE ) { strcpy(letter,"[<]"); }
+	else if( key == KBD_CHAR_LEFT ) { strcpy(letter,"[<-]"); }
+	else if( key == KBD_CHAR_RIGHT ) { strcpy(letter,"[->]"); }
+	// format 'special mode' keyboard characters
+	else if( key == '-' && (this->keyset & (KEYSET_NEGATIVE | KEYSET_HOSTNAME)) ) { strcpy(letter,"[-]"); }
+	else if( key == '.' && (this->keyset & (KEYSET_FLOAT | KEYSET_HOSTNAME | KEYSET_IPADDR))) { strcpy(letter,"[.]"); }
+	// alpha-numeric key, no formatting
+	else {
+		letter[0] = key;
+		letter[1] = '\0';
+	}
+
+	gui->UG_SetForecolor( color );
+	this->drawText( gui, x, KEYSET_KEYS_Y + (i * KEYSET_KEYS_PITCH), letter );
+}
+
+
+/**
+ * @brief draw the keyboard character set column
+ * 
+ * @param x left edge of the key column
+ * @param setlen number of selectable keys
+ * @param limit maxlen reached, only DELETE, RETURN, and the cursor keys are shown
+ * @param blinkOnly only redraw the selected key
+*/
+void Keyboard::drawKeys( UGUI *gui, int x, int setlen, bool limit, bool blinkOnly ) {
+	UG_COLOR accentColor = COLOR_BRIGHTER( this->color );
+	UG_COLOR darkerColor = COLOR_DARKER( this->color );
+
+	// maxlen reached only allow DELETE, RETURN, and cursor movement -- the keys don't wrap around
+	if( limit ) {
+		int selected = this->cursor % setlen;
+		for( int i=0; i < setlen; i++ ) {
+			int row = 2 + i - selected;
+			if( row < 0 || row > 4 ) continue;
+			this->drawKey( gui, x, row, this->limitKey( i ), i == selected ? accentColor : this->color );
+		}
+		return;
+	}
+
+	// draw keyboard character set, selected key blinks
+	int index = this->cursor - 2;
+	if( index < 0 ) index = setlen + index;
+	for( int i=0; i < 5; i++ ) {
+		if( blinkOnly && i != 2 ) continue;
+		char key = this->keyAt( (index + i) % setlen );
+		this->drawKey( gui, x, i, key, i == 2 ? (this->blinking ? accentColor : darkerColor) : this->color );
+	}
+}
+
+
+/**
+ * @brief draw the text after the cursor of the editing mode, right of the selected key
+ * 
+ * @param x left edge of the text
+ * @param width display width
+ * @param point cursor position
+*/
+void Keyboard::drawTail( UGUI *gui, int x, int width, uint point ) {
+	char tail[ KEYSET_WIDTH_MAX + 1 ];
+	int count = (width - x) / KEYSET_CELL_W;
+	if( count <= 0 ) return;
+	if( count > KEYSET_WIDTH_MAX ) count = KEYSET_WIDTH_MAX;
+	this->gap.copy( point, tail, count );
+	gui->UG_SetForecolor( this->color );
+	this->drawText( gui, x, KEYSET_TEXT_Y, tail );
+}
+
+
 /**
  * @brief display keyboard and handle user input
  * 
  * @note the calling application is responsible for updating button state by calling: updateInput()
  * @note by default the display will auto-update, set the autoupdate member to false to disable this behaviour
+ * @note only the parts of the keyboard that changed since the last frame are redrawn, the updated member tells if anything was drawn
  * 
  * @return boolean flag indicating if text buffer has changed
 */
 bool Keyboard::getchar() {
+	TRACE_SCOPE("kbd frame");
 
 	// calculate blinking effect
 	this->interval += (micros() - lastFrame) / 1000.0;
@@ -384,96 +954,105 @@ bool Keyboard::getchar() {
 	// set keyboard active flag
 	this->active = true;
 
-	// get system color and make highlight color
-	UG_COLOR accentColor = COLOR_BRIGHTER( this->color );
-	UG_COLOR darkerColor = COLOR_DARKER( this->color );
-
 	// get display size
 	uint16_t sizeX;
 	uint16_t sizeY;
 	pocuter->Display->getDisplaySize(sizeX, sizeY);
-
-	// clear screen
-	UGUI* gui = pocuter->ugui;	
-	gui->UG_FillFrame(0, 0, sizeX, sizeY, C_BLACK);
-	gui->UG_FontSelect(&FONT_POCUTER_5X7);
-
-	// draw keyboard label
-	gui->UG_SetForecolor( accentColor );	
-	gui->UG_PutStringSingleLine(0, 0, this->label);
-
-	// draw keyboard text
-	gui->UG_SetForecolor( this->color );	
-	uint textlen = strlen( this->text );
-	uint textpos = 0;
-	if( textlen ) {
-		// text fits within screen width
-		if( textlen <= KEYSET_WIDTH_MAX ) {
-			gui->UG_PutStringSingleLine(0, 32, this->text);
-			textpos = gui->UG_StringWidth( this->text );
-		} else {
-			// truncate/scroll text to the left
-			char textfrag[KEYSET_WIDTH_MAX + 1];
-			uint start = textlen - KEYSET_WIDTH_MAX;
-			strncpy(textfrag, this->text + start, KEYSET_WIDTH_MAX);
-			textfrag[KEYSET_WIDTH_MAX] = '\0';
-			gui->UG_PutStringSingleLine(0, 32, textfrag);
-			textpos = gui->UG_StringWidth( textfrag );
-		}
+	unsigned long drawStart = micros();
+
+	// current text and key set state -- the editing mode text is a plain string while its cursor is at the end
+	uint textlen = this->editing ? this->gap.length() : strlen( this->text );
+	uint point = this->editing ? this->gap.cursor() : textlen;
+	bool inside = point < textlen;
+	if( this->editing && !inside ) this->gap.text();
+	this->charlen = strlen( this->charset );
+	int editKeys = this->editing ? 2 : 0;
+	bool limit = textlen == this->maxlen;
+
+	// completion candidates: looked up when the text changed, only offered at the end of the text
+	if( inside ) {
+		this->candidateCount = 0;
+		this->candidateTextlen = -1;
+		if( this->cursor >= this->charlen + editKeys ) this->cursor = this->charlen - 1;
+	} else if( this->completion && (int) textlen != this->candidateTextlen ) {
+		this->updateCandidates( textlen );
+		if( this->cursor >= this->charlen + editKeys + (int) this->candidateCount ) this->cursor = this->charlen - 1;
 	}
+	int setlen = limit ? 2 + editKeys : this->charlen + editKeys + this->candidateCount;
 
-	// current cursor key state
-	int setlen = strlen( this->charset );
-	char letter[5];	
+	// current cursor key
 	char curkey;
-
-	// maxlen reached only allow DELETE and RETURN
-	if( textlen == this->maxlen ) {
-		setlen = 2;
-		if( this->cursor % 2 ) {
-			gui->UG_SetForecolor( this->color );
-			gui->UG_PutStringSingleLine( textpos + 2, 24, "[<]" );
-			gui->UG_SetForecolor( accentColor );
-			gui->UG_PutStringSingleLine( textpos + 2, 32, "[OK]" );
-			curkey = '\n';
-		} else {
-			gui->UG_SetForecolor( accentColor );
-			gui->UG_PutStringSingleLine( textpos + 2, 32, "[<]" );
-			gui->UG_SetForecolor( this->color );
-			gui->UG_PutStringSingleLine( textpos + 2, 40, "[OK]" );
-			curkey = '\r';
-		}
-	}
-
-	// draw keyboard character set
-	else {
+	if( limit ) {
+		curkey = this->limitKey( this->cursor % setlen );
+	} else {
 		int index = this->cursor - 2;
 		if( index < 0 ) index = setlen + index;
-		for( int i=0; i < 5; i++ ) {
-			
-			// get keyset character
-			char key = this->charset[ (index + i) % setlen ];
-
-			// format keyboard 'action' characters 
-			if( key == KBD_CHAR_RETURN ) { strcpy(letter,"[OK]"); }
-			else if( key == KBD_CHAR_SPACE ) { strcpy(letter,"[ ]"); }
-			else if( key == KBD_CHAR_DELETE ) { strcpy(letter,"[<]"); }
-			// format 'special mode' keyboard characters
-			else if( key == '-' && (this->keyset & (KEYSET_NEGATIVE | KEYSET_HOSTNAME)) ) { strcpy(letter,"[-]"); }
-			else if( key == '.' && (this->keyset & (KEYSET_FLOAT | KEYSET_HOSTNAME | KEYSET_IPADDR))) { strcpy(letter,"[.]"); }
-			// alpha-numeric key, no formatting
-			else {
-				letter[0] = key;
-				letter[1] = '\0';
-			}
+		curkey = this->keyAt( (index + 2) % setlen );
+	}
 
-			// store selected keyboard character 
-			if( i == 2 ) curkey = key;
+	// compare with last rendered frame
+	bool full = !this->drawn || this->color != this->drawnColor;
+	bool textChanged = full || textlen != this->drawnTextlen || point != this->drawnPoint;
+	bool keysChanged = textChanged || this->cursor != this->drawnCursor || limit != this->drawnLimit;
+	bool blinkChanged = keysChanged || (!limit && this->blinking != this->drawnBlink);
+	this->updated = blinkChanged;
+	this->stats.frames++;
+
+	// redraw changed parts of the keyboard
+	UGUI* gui = pocuter->ugui;
+	int textpos = this->drawnTextpos;
+	int tailpos = textpos + 2 + KEYSET_EDIT_SLOT * KEYSET_CELL_W + 2;
+	if( this->updated ) {
+		TRACE_SCOPE("kbd draw");
+		gui->UG_FontSelect(&FONT_POCUTER_5X7);
+
+		// full: clear screen and draw keyboard label
+		if( full ) {
+			this->drawFill( gui, 0, 0, sizeX - 1, sizeY - 1 );
+			gui->UG_SetForecolor( COLOR_BRIGHTER( this->color ) );
+			this->drawText( gui, 0, 0, this->label );
+		}
+
+		// text: draw the tail of the text that fits the screen width, the key column follows it
+		// - editing mode: the text up to the cursor, scrolled to keep a margin left of the cursor
+		if( textChanged ) {
+			if( !full ) this->drawFill( gui, 0, KEYSET_KEYS_Y, sizeX - 1, sizeY - 1 );
+			char view[ KEYSET_EDIT_WIDTH + 1 ];
+			const char *textfrag = this->text;
+			if( this->editing ) {
+				if( point < this->viewStart + KEYSET_EDIT_MARGIN ) this->viewStart = point > KEYSET_EDIT_MARGIN ? point - KEYSET_EDIT_MARGIN : 0;
+				if( point > this->viewStart + KEYSET_EDIT_WIDTH ) this->viewStart = point - KEYSET_EDIT_WIDTH;
+				this->gap.copy( this->viewStart, view, point - this->viewStart );
+				textfrag = view;
+			} else if( textlen > KEYSET_WIDTH_MAX ) textfrag += textlen - KEYSET_WIDTH_MAX;
+			textpos = textfrag[0] ? gui->UG_StringWidth( textfrag ) : 0;
+			tailpos = textpos + 2 + KEYSET_EDIT_SLOT * KEYSET_CELL_W + 2;
+			gui->UG_SetForecolor( this->color );
+			if( textfrag[0] ) this->drawText( gui, 0, KEYSET_TEXT_Y, textfrag );
+		}
 
-			// set highlight/blink color and draw character to screen
-			gui->UG_SetForecolor( i == 2 ? (this->blinking ? accentColor : darkerColor) : this->color );
-			gui->UG_PutStringSingleLine( textpos + 2, 14+(i*9), letter );
+		// keys: clear the key column, or only the selected key row when just the blink phase changed
+		// - editing mode: the text after the cursor follows the selected key
+		if( keysChanged ) {
+			if( !textChanged ) this->drawFill( gui, textpos + 2, KEYSET_KEYS_Y, sizeX - 1, sizeY - 1 );
+			this->drawKeys( gui, textpos + 2, setlen, limit, false );
+			if( inside ) this->drawTail( gui, tailpos, sizeX, point );
+		} else if( !limit ) {
+			this->drawFill( gui, textpos + 2, KEYSET_TEXT_Y, inside ? tailpos - 1 : sizeX - 1, KEYSET_TEXT_Y + KEYSET_CELL_H );
+			this->drawKeys( gui, textpos + 2, setlen, limit, true );
 		}
+
+		// save rendered state
+		this->drawn = true;
+		this->drawnTextlen = textlen;
+		this->drawnPoint = point;
+		this->drawnTextpos = textpos;
+		this->drawnCursor = this->cursor;
+		this->drawnBlink = this->blinking;
+		this->drawnLimit = limit;
+		this->drawnColor = this->color;
+		this->stats.draws++;
+		this->stats.micros += micros() - drawStart;
 	}
 
 	// cache: current scrolling hold state
@@ -494,27 +1073,50 @@ bool Keyboard::getchar() {
 	}
 
 	// button: SELECT EVENT
-	if( ACTION_SINGLE_CLICK_C || (ACTION_HOLD_C && curkey == KBD_CHAR_DELETE )) {
+	bool repeating = curkey == KBD_CHAR_DELETE || curkey == KBD_CHAR_LEFT || curkey == KBD_CHAR_RIGHT;
+	if( ACTION_SINGLE_CLICK_C || (ACTION_HOLD_C && repeating )) {
+		TRACE_INSTANT("kbd select");
 
 		// key: RETURN EVENT
 		 if( curkey == KBD_CHAR_RETURN ) { 			
 			changed = true;
 
+			// editing: the rules below read the text as a plain string
+			if( inside ) this->gap.text();
+
 			// test: HOSTNAME doesn't end in '-' char
 			if( (this->keyset & KEYSET_HOSTNAME) && textlen && this->text[textlen-1] == '-' ) {
 				// -- remove trailing character --
 				this->text[ --textlen ] = '\0';
 			} 
 			
-			// else: end active keyboard state
+			// else: end active keyboard state, next activation draws the whole keyboard
 			else {
 				this->active = false;
+				this->drawn = false;
 			}
 		}
 
+		// key: COMPLETION EVENT -- replace the text, or the current word, select [OK] key
+		else if( curkey >= KBD_CHAR_WORD && curkey < KBD_CHAR_WORD + KEYBOARD_CANDIDATES ) {
+			uint start = this->completion->start[ curkey - KBD_CHAR_WORD ];
+			strncpy( this->text + start, this->completion->list[ curkey - KBD_CHAR_WORD ], this->maxlen - start );
+			this->text[ this->maxlen ] = '\0';
+			textlen = strlen( this->text );
+			this->cursor = this->charlen - 1;
+			changed = true;
+		}
+
+		// key: CURSOR EVENT -- editing mode, moves the text cursor
+		else if( curkey == KBD_CHAR_LEFT || curkey == KBD_CHAR_RIGHT ) {
+			this->scrolling = ACTION_HOLD_C;
+			if( !(!this->scrolling && curScrolling) )
+				this->gap.move( curkey == KBD_CHAR_LEFT ? -1 : 1 );
+		}
+
 		// key: DELETE EVENT
 		else if( curkey == KBD_CHAR_DELETE ) { 
-			if( textlen ) {
+			if( point ) {
 				this->scrolling = ACTION_HOLD_C;
 				if( !(!this->scrolling && curScrolling) ) {
 
@@ -522,21 +1124,39 @@ bool Keyboard::getchar() {
 					if( textlen == this->maxlen )
 						this->cursor = strlen( this->charset ) - 2;
 
+					// -- remove character before the text cursor --
+					if( inside ) {
+						this->gap.erase();
+						textlen--;
+					}
+
 					// -- remove trailing character --
-					this->text[ --textlen ] = '\0';
+					else this->text[ --textlen ] = '\0';
 					changed = true;
 				}
 			}
 		}
 
+		// key: INSERT EVENT -- editing mode with the text cursor inside the text, no formatting rules
+		else if( inside ) {
+			if( textlen < this->maxlen ) {
+				this->gap.insert( curkey );
+				changed = true;
+
+				// adjust cursor if max length (set to delete), or return it to the first key
+				if( ++textlen == this->maxlen || (this->keyset & KEYSET_HOME) )
+					this->cursor = 0;
+			}
+		}
+
 		// key: APPEND EVENT
 		else if( textlen < this->maxlen ){
 			this->text[ textlen ] = curkey;
 			this->text[ ++textlen ] = '\0';
 			changed = true;
 
-			// adjust cursor if max length (set to delete)
-			if( textlen == this->maxlen )
+			// adjust cursor if max length (set to delete), or return it to the first key
+			if( textlen == this->maxlen || (this->keyset & KEYSET_HOME) )
 				this->cursor = 0;
 
 			// mode: numeric sub-type negative number handling (fall-through)
@@ -652,16 +1272,48 @@ bool Keyboard::getchar() {
 				}
 			}
 		}
+
+		// editing: take over the plain string changed above, the text cursor moves to its end
+		if( this->editing && textlen != this->gap.length() ) this->gap.reset( textlen );
 	}
 
-	// update screen
-	if( this->autoupdate )
+	// update screen when the keyboard was redrawn
+	if( this->autoupdate && this->updated ) {
+		TRACE_SCOPE("kbd screen");
 		pocuter->Display->updateScreen();
+	}
 
 	// return text changed flag
 	return changed;
 }
 
+/**
+* @brief PocuterUtil::KeyboardT -- Keyboard with compile-time key set and text buffer size
+*
+* @note the character set is selected at compile time and the text buffer is a member sized by the
+*       maximum length, no memory is allocated unless custom() or complete() is used
+*
+* @tparam Keyset character set bit flags
+* @tparam MaxLen maximum length of keyboard text, must be <= 255
+*/
+template< uint16_t Keyset, uint MaxLen >
+class KeyboardT : public Keyboard {
+	static_assert( MaxLen > 0 && MaxLen <= KEYSET_STRING_MAX, "KeyboardT: MaxLen must be 1..255" );
+
+	private:
+		static constexpr const char* chars = keysetCharset( Keyset );
+		char buffer[ MaxLen + 1 + KEYSET_TEXT_PAD ];
+
+	public:
+		/**
+		 * @brief KeyboardT Constructor
+		 * 
+		 * @param pocuter pointer to Pocuter system object
+		 * @param label keyboard label text
+		*/
+		KeyboardT( Pocuter *pocuter, char *label ) : Keyboard( pocuter, label, Keyset, MaxLen, buffer, chars ) {}
+};
+
 /*
 	Close the 'PocuterUtil' namespace
 */
@@ -671,10 +1323,23 @@ bool Keyboard::getchar() {
 #undef KEYSET_WIDTH_MAX
 #undef KEYSET_STRING_MAX
 #undef KEYSET_BLINK_LEN
+#undef KEYSET_TEXT_PAD
+#undef KEYSET_TEXT_Y
+#undef KEYSET_KEYS_Y
+#undef KEYSET_KEYS_PITCH
+#undef KEYSET_CELL_W
+#undef KEYSET_CELL_H
+#undef KEYSET_EDIT_WIDTH
+#undef KEYSET_EDIT_MARGIN
+#undef KEYSET_EDIT_SLOT
+#undef KEYSET_WORD_BREAK
 
 #undef KBD_CHAR_SPACE
 #undef KBD_CHAR_DELETE
 #undef KBD_CHAR_RETURN
+#undef KBD_CHAR_WORD
+#undef KBD_CHAR_LEFT
+#undef KBD_CHAR_RIGHT
 
 #undef CHARSET_NONE
 
@@ -685,4 +1350,17 @@ bool Keyboard::getchar() {
 #undef COLOR_BRIGHTER
 #undef COLOR_DARKER
 
+#ifdef KEYBOARD_TRACE_STUBS
+#undef KEYBOARD_TRACE_STUBS
+#undef TRACE_SCOPE
+#undef TRACE_INSTANT
+#endif
+
+#undef KEYSET_PICK_0
+#undef KEYSET_PICK_1
+#undef KEYSET_CHARS
+#undef KEYSET_CHARS_4
+#undef KEYSET_CHARS_16
+#undef KEYSET_COMPOSABLE
+
 #endif // _POCUTERUTIL_KEYBOARD_H_
\ No newline at end of file
@@ -0,0 +1,284 @@
+//
+// Copyright 2023 Kallistisoft
+// GNU GPL-3 https://www.gnu.org/licenses/gpl-3.0.txt
+/*
+* [PocuterUtils]/Libs/Keyboard/KeyboardDict.h
+*
+* PocuterUtils::KeyboardDict -- Paged word completion dictionary for PocuterUtil::Keyboard
+*
+* Dictionary files are created with the tools/build-dict script, see README.md file for details
+*/
+
+#ifndef _POCUTERUTIL_KEYBOARDDICT_H_
+#define _POCUTERUTIL_KEYBOARDDICT_H_
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+// global: dictionary file format and page cache size
+#define KEYBOARD_DICT_MAGIC       "PKD1"  /**< dictionary file signature and version */
+#define KEYBOARD_DICT_HEADER      16      /**< header: magic, root node offset, word count, node count */
+#define KEYBOARD_DICT_PAGE_SIZE   128     /**< bytes per cached file page */
+#define KEYBOARD_DICT_PAGES       8       /**< cached file pages */
+#define KEYBOARD_DICT_CANDIDATES  3       /**< best completions stored per trie node */
+#define KEYBOARD_DICT_WORD_MAX    32      /**< longest dictionary word */
+
+// ------------------------------------------------------------------------------------------------
+//
+//	Use the 'PocuterUtil' namespace
+//
+namespace PocuterUtil {
+/**
+* @brief PocuterUtil::KeyboardDict -- Paged word completion dictionary
+*
+* The dictionary is a trie stored on the sd card, each node holds its sorted child links and the
+* offsets of the most frequent words below it. A lookup walks one node per prefix character and
+* reads the nodes through a small page cache -- the file is never loaded into memory.
+*
+* @note See README.md file for details and the dictionary file format
+*/
+// ------------------------------------------------------------------------------------------------
+class KeyboardDict {
+	private:
+		// dictionary file
+		char path[64];
+		FILE *file;
+		bool failed;
+
+		// header fields
+		uint32_t root;
+		uint32_t words;
+
+		// page cache, least recently used page is replaced
+		uint8_t pages[KEYBOARD_DICT_PAGES][KEYBOARD_DICT_PAGE_SIZE];
+		uint32_t pageIndex[KEYBOARD_DICT_PAGES];
+		uint32_t pageAge[KEYBOARD_DICT_PAGES];
+		uint32_t clock;
+
+		bool open();
+		const uint8_t* page( uint32_t offset );
+		bool read( uint32_t offset, uint8_t *dest, size_t len );
+		uint32_t read24( uint32_t offset );
+
+	public:
+		uint32_t reads;  /**< pages read from the sd card */
+		uint32_t hits;   /**< page cache hits */
+
+		KeyboardDict( const char *path );
+		~KeyboardDict();
+
+		void close();
+		uint32_t size();
+		int lookup( const char *prefix, char words[][KEYBOARD_DICT_WORD_MAX + 1], int max );
+};
+/**
+ * @brief Dictionary Constructor -- the file is opened on the first lookup
+ *
+ * @param path full path of the dictionary file, for example: "/sd/dict/english.pkd"
+*/
+KeyboardDict::KeyboardDict( const char *path ) {
+	memset( this->path, 0, sizeof(this->path) );
+	strncpy( this->path, path, sizeof(this->path) - 1 );
+	this->file = NULL;
+	this->failed = false;
+	this->root = 0;
+	this->words = 0;
+	this->reads = 0;
+	this->hits = 0;
+	this->close();
+}
+
+
+/**
+ * @brief Dictionary Destructor
+*/
+KeyboardDict::~KeyboardDict() {
+	this->close();
+}
+
+
+/**
+ * @brief close the dictionary file and drop the page cache
+ *
+ * @note the next lookup re-opens the file, for example after the sd card was re-mounted
+*/
+void KeyboardDict::close() {
+	if( this->file ) fclose( this->file );
+	this->file = NULL;
+	this->failed = false;
+	this->clock = 0;
+	for( int i=0; i < KEYBOARD_DICT_PAGES; i++ ) {
+		this->pageIndex[i] = UINT32_MAX;
+		this->pageAge[i] = 0;
+	}
+}
+
+
+/**
+ * @brief open the dictionary file and validate the header
+ *
+ * @return boolean flag indicating if the dictionary is usable
+*/
+bool KeyboardDict::open() {
+	if( this->file ) return true;
+	if( this->failed ) return false;
+
+	// open: a missing or invalid file isn't retried until close() is called
+	this->failed = true;
+	this->file = fopen( this->path, "rb" );
+	if( !this->file ) return false;
+
+	uint8_t header[KEYBOARD_DICT_HEADER];
+	if( fread( header, 1, KEYBOARD_DICT_HEADER, this->file ) != KEYBOARD_DICT_HEADER || memcmp( header, KEYBOARD_DICT_MAGIC, 4 ) != 0 ) {
+		fclose( this->file );
+		this->file = NULL;
+		return false;
+	}
+	this->root  = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+	this->words = header[8] | (header[9] << 8) | (header[10] << 16) | ((uint32_t)header[11] << 24);
+	this->failed = false;
+	return true;
+}
+
+
+/**
+ * @brief get the cached page containing a file offset
+ *
+ * @return pointer to the byte at offset, NULL on read error
+*/
+const uint8_t* KeyboardDict::page( uint32_t offset ) {
+	uint32_t index = offset / KEYBOARD_DICT_PAGE_SIZE;
+	uint32_t pos = offset % KEYBOARD_DICT_PAGE_SIZE;
+
+	// cache hit: refresh page age
+	int oldest = 0;
+	for( int i=0; i < KEYBOARD_DICT_PAGES; i++ ) {
+		if( this->pageIndex[i] == index ) {
+			this->pageAge[i] = ++this->clock;
+			this->hits++;
+			return &this->pages[i][pos];
+		}
+		if( this->pageAge[i] < this->pageAge[oldest] ) oldest = i;
+	}
+
+	// cache miss: replace least recently used page, the last page of the file may be short
+	this->pageIndex[oldest] = UINT32_MAX;
+	if( fseek( this->file, index * KEYBOARD_DICT_PAGE_SIZE, SEEK_SET ) != 0 ) return NULL;
+	size_t len = fread( this->pages[oldest], 1, KEYBOARD_DICT_PAGE_SIZE, this->file );
+	if( len <= pos ) return NULL;
+	memset( this->pages[oldest] + len, 0, KEYBOARD_DICT_PAGE_SIZE - len );
+	this->pageIndex[oldest] = index;
+	this->pageAge[oldest] = ++this->clock;
+	this->reads++;
+	return &this->pages[oldest][pos];
+}
+
+
+/**
+ * @brief copy bytes from the dictionary file through the page cache
+ *
+ * @return boolean flag indicating if all bytes were read
+*/
+bool KeyboardDict::read( uint32_t offset, uint8_t *dest, size_t len ) {
+	while( len ) {
+		const uint8_t *src = this->page( offset );
+		if( !src ) return false;
+		size_t count = KEYBOARD_DICT_PAGE_SIZE - (offset % KEYBOARD_DICT_PAGE_SIZE);
+		if( count > len ) count = len;
+		memcpy( dest, src, count );
+		dest += count;
+		offset += count;
+		len -= count;
+	}
+	return true;
+}
+
+
+/**
+ * @brief read little-endian 24 bit file offset
+ *
+ * @return offset value, 0 on read error
+*/
+uint32_t KeyboardDict::read24( uint32_t offset ) {
+	uint8_t value[3];
+	if( !this->read( offset, value, 3 ) ) return 0;
+	return value[0] | (value[1] << 8) | (value[2] << 16);
+}
+
+
+/**
+ * @brief get the number of words in the dictionary
+ *
+ * @return word count, 0 if the dictionary can't be opened
+*/
+uint32_t KeyboardDict::size() {
+	return this->open() ? this->words : 0;
+}
+
+
+/**
+ * @brief find the most frequent words starting with a prefix
+ *
+ * @note reads one trie node per prefix character plus the candidate words
+ *
+ * @param prefix word prefix, an empty prefix returns the most frequent words
+ * @param words destination word buffers
+ * @param max size of the destination array
+ *
+ * @return number of words found
+*/
+int KeyboardDict::lookup( const char *prefix, char words[][KEYBOARD_DICT_WORD_MAX + 1], int max ) {
+	if( !this->open() ) return 0;
+
+	// node: [flags:u8][children:u8][candidates:u8] [char:u8 offset:u24]*children [offset:u24]*candidates
+	uint8_t node[3];
+	uint32_t offset = this->root;
+	for( const char *c = prefix; ; c++ ) {
+		if( !this->read( offset, node, 3 ) ) return 0;
+		if( *c == '\0' ) break;
+
+		// binary search: children are sorted by character
+		int lo = 0;
+		int hi = node[1] - 1;
+		uint32_t next = 0;
+		while( lo <= hi ) {
+			int mid = (lo + hi) / 2;
+			uint8_t link[4];
+			if( !this->read( offset + 3 + mid * 4, link, 4 ) ) return 0;
+			if( link[0] == (uint8_t) *c ) {
+				next = link[1] | (link[2] << 8) | (link[3] << 16);
+				break;
+			}
+			if( link[0] < (uint8_t) *c ) lo = mid + 1;
+			else hi = mid - 1;
+		}
+		if( !next ) return 0;
+		offset = next;
+	}
+
+	// candidates: null-terminated words in the string pool
+	int count = 0;
+	uint32_t list = offset + 3 + node[1] * 4;
+	for( int i=0; i < node[2] && count < max; i++ ) {
+		uint32_t word = this->read24( list + i * 3 );
+		if( !word ) break;
+
+		int len = 0;
+		while( len < KEYBOARD_DICT_WORD_MAX ) {
+			const uint8_t *src = this->page( word + len );
+			if( !src || *src == '\0' ) break;
+			words[count][len++] = *src;
+		}
+		words[count][len] = '\0';
+		if( len ) count++;
+	}
+	return count;
+}
+
+/*
+	Close the 'PocuterUtil' namespace
+*/
+};
+
+#endif // _POCUTERUTIL_KEYBOARDDICT_H_
@@ -0,0 +1,233 @@
+//
+// Copyright 2023 Kallistisoft
+// GNU GPL-3 https://www.gnu.org/licenses/gpl-3.0.txt
+/*
+* [PocuterUtils]/Libs/Keyboard/KeyboardGap.h
+*
+* PocuterUtils::KeyboardGap -- Gap buffer for the editing mode of PocuterUtil::Keyboard
+*
+* See README.md file for details
+*/
+
+#ifndef _POCUTERUTIL_KEYBOARDGAP_H_
+#define _POCUTERUTIL_KEYBOARDGAP_H_
+
+#include <cstring>
+#include <cstdint>
+
+// ------------------------------------------------------------------------------------------------
+//
+//	Use the 'PocuterUtil' namespace
+//
+namespace PocuterUtil {
+/**
+* @brief PocuterUtil::KeyboardGap -- Gap buffer over a caller provided text buffer
+*
+* The text is kept in two parts, before and after a gap of free bytes. Characters are inserted
+* and deleted at the gap without moving the rest of the text. The cursor moves without touching
+* the buffer, the gap follows it on the next edit -- each character the cursor passed is moved
+* once, so a sequence of moves and edits costs O(1) per operation.
+*
+* @note the buffer has one byte more than the capacity, text() terminates the text in place
+*/
+// ------------------------------------------------------------------------------------------------
+class KeyboardGap {
+	private:
+		// text buffer, the gap is [gapStart, gapEnd)
+		char *buffer;
+		uint32_t capacity;
+		uint32_t gapStart;
+		uint32_t gapEnd;
+
+		// cursor position in the text
+		uint32_t point;
+
+		void moveGap( uint32_t position );
+
+	public:
+		uint32_t moves;  /**< characters moved across the gap */
+
+		KeyboardGap();
+
+		void init( char *buffer, uint32_t capacity );
+		void set( const char *text );
+		void reset( uint32_t length );
+
+		uint32_t length() const { return this->capacity - (this->gapEnd - this->gapStart); }
+		uint32_t cursor() const { return this->point; }
+		char at( uint32_t index ) const;
+		uint32_t copy( uint32_t start, char *dest, uint32_t count ) const;
+
+		void moveTo( uint32_t position );
+		void move( int offset );
+		bool insert( char c );
+		bool erase();
+
+		char* text();
+};
+/**
+ * @brief Gap Buffer Constructor -- no buffer is attached until init()
+*/
+KeyboardGap::KeyboardGap() {
+	this->init( NULL, 0 );
+}
+
+
+/**
+ * @brief attach a text buffer, the text is empty
+ *
+ * @param buffer text buffer of capacity + 1 bytes
+ * @param capacity maximum text length
+*/
+void KeyboardGap::init( char *buffer, uint32_t capacity ) {
+	this->buffer = buffer;
+	this->capacity = buffer ? capacity : 0;
+	this->gapStart = 0;
+	this->gapEnd = this->capacity;
+	this->point = 0;
+	this->moves = 0;
+}
+
+
+/**
+ * @brief copy text into the buffer, the cursor is placed at the end
+ *
+ * @param text new text, truncated to the capacity
+*/
+void KeyboardGap::set( const char *text ) {
+	uint32_t len = strnlen( text, this->capacity );
+	memmove( this->buffer, text, len );
+	this->reset( len );
+}
+
+
+/**
+ * @brief take over a text that was written to the start of the buffer, the cursor is placed at the end
+ *
+ * @param length text length
+*/
+void KeyboardGap::reset( uint32_t length ) {
+	if( length > this->capacity ) length = this->capacity;
+	this->gapStart = length;
+	this->gapEnd = this->capacity;
+	this->point = length;
+	this->buffer[ length ] = '\0';
+}
+
+
+/**
+ * @brief get character of the text
+ *
+ * @param index position in the text, must be less than length()
+*/
+char KeyboardGap::at( uint32_t index ) const {
+	return this->buffer[ index < this->gapStart ? index : index + (this->gapEnd - this->gapStart) ];
+}
+
+
+/**
+ * @brief copy part of the text without moving the gap, for example the visible part of the text
+ *
+ * @param start first position in the text
+ * @param dest destination of count + 1 bytes, the copy is terminated
+ * @param count characters to copy at most
+ *
+ * @return characters copied
+*/
+uint32_t KeyboardGap::copy( uint32_t start, char *dest, uint32_t count ) const {
+	uint32_t len = this->length();
+	if( start > len ) start = len;
+	if( count > len - start ) count = len - start;
+
+	// before the gap, then after it
+	uint32_t head = start < this->gapStart ? this->gapStart - start : 0;
+	if( head > count ) head = count;
+	memcpy( dest, this->buffer + start, head );
+	if( count > head ) memcpy( dest + head, this->buffer + this->gapEnd + (start + head - this->gapStart), count - head );
+	dest[ count ] = '\0';
+	return count;
+}
+
+
+/**
+ * @brief move the gap to a text position
+*/
+void KeyboardGap::moveGap( uint32_t position ) {
+	uint32_t gap = this->gapEnd - this->gapStart;
+	if( position < this->gapStart ) {
+		uint32_t count = this->gapStart - position;
+		memmove( this->buffer + position + gap, this->buffer + position, count );
+		this->moves += count;
+	} else if( position > this->gapStart ) {
+		uint32_t count = position - this->gapStart;
+		memmove( this->buffer + this->gapStart, this->buffer + this->gapEnd, count );
+		this->moves += count;
+	}
+	this->gapStart = position;
+	this->gapEnd = position + gap;
+}
+
+
+/**
+ * @brief set the cursor position, clamped to the text
+*/
+void KeyboardGap::moveTo( uint32_t position ) {
+	uint32_t len = this->length();
+	this->point = position > len ? len : position;
+}
+
+
+/**
+ * @brief move the cursor by a number of characters, clamped to the text
+*/
+void KeyboardGap::move( int offset ) {
+	if( offset < 0 && (uint32_t) -offset > this->point ) this->point = 0;
+	else this->moveTo( this->point + offset );
+}
+
+
+/**
+ * @brief insert a character at the cursor, the cursor moves past it
+ *
+ * @return false if the buffer is full
+*/
+bool KeyboardGap::insert( char c ) {
+	if( this->gapStart == this->gapEnd ) return false;
+	this->moveGap( this->point );
+	this->buffer[ this->gapStart++ ] = c;
+	this->point++;
+	return true;
+}
+
+
+/**
+ * @brief delete the character before the cursor
+ *
+ * @return false if the cursor is at the start of the text
+*/
+bool KeyboardGap::erase() {
+	if( !this->point ) return false;
+	this->moveGap( this->point );
+	this->gapStart--;
+	this->point--;
+	return true;
+}
+
+
+/**
+ * @brief get the text as a terminated string -- the gap is moved to the end, the cursor is kept
+ *
+ * @return pointer to the start of the buffer
+*/
+char* KeyboardGap::text() {
+	this->moveGap( this->length() );
+	this->buffer[ this->gapStart ] = '\0';
+	return this->buffer;
+}
+
+/*
+	Close the 'PocuterUtil' namespace
+*/
+};
+
+#endif // _POCUTERUTIL_KEYBOARDGAP_H_
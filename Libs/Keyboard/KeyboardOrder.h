@@ -0,0 +1,110 @@
+//
+// Copyright 2023 Kallistisoft
+// GNU GPL-3 https://www.gnu.org/licenses/gpl-3.0.txt
+/*
+* [PocuterUtils]/Libs/Keyboard/KeyboardOrder.h
+*
+* PocuterUtils::Keyboard -- Key orders with fewer button presses, selected by KEYSET_ORDERED
+*
+* Generated by: tools/order-keys -o KeyboardOrder.h ../../LICENSE
+*/
+
+#ifndef _POCUTERUTIL_KEYBOARDORDER_H_
+#define _POCUTERUTIL_KEYBOARDORDER_H_
+
+namespace PocuterUtil {
+
+// key orders: cursor stays on the selected key -- indexed by the composable flag bits
+static constexpr const char* const keysetOrderStay[ 32 ] = {
+	"-\r\n",  // 0x00
+	"-ATESNIHDLGVWXZJQKBYUPMFCOR\r\n",  // 0x01
+	"-atesnihdlgvwxzjqkbyupmfcor\r\n",  // 0x02
+	"-itachmgwLPATIGNDEROHUMBVWQZJXKzFCYSjqxkbvylpufdonres\r\n",  // 0x03
+	"-1234680795\r\n",  // 0x04
+	"-ORESNTIACHLGWVXZ4869520731JQKBYPMUFD\r\n",  // 0x05
+	"-oresntiachlgwvxz4869520731jqkbypmufd\r\n",  // 0x06
+	"-esnitahmgwvLITGARONUDEHMWVBzQ8ZJX9654K70231jYqFCxSPkbyplufdcor\r\n",  // 0x07
+	"-,.)(-/:<>]@$^*+{|=~}?_&%#![\\`;'\"\r\n",  // 0x08
+	"-AROSETNICHDGVXQ-Z:/<`^&*_}?#@+\\[]!$%|~={>;'J()\"K.,BWMYLPUF\r\n",  // 0x09
+	"-arosetnichdgvxq-z:/<`^&*_}?#@+\\[]!$%|~={>;'j()\"k.,bwmylpuf\r\n",  // 0x0A
+	"-atesinhdmgwv,.k\"x)(q'-;z<:>/`J!?\\@$^*+{|=~}_&%#[Z]KXQVWBMjFHYDEROUNGITACSPLbylpufcor\r\n",  // 0x0B
+	"-1234680-=~,./\\;:[]!@#$%^&*()_+<>?'\"`{}|975\r\n",  // 0x0C
+	"-ASERNOTICHFGWVX(-:/><Z`!]*~#\\%}=@?+_&[|{$^9864527031';JQ)\".K,BYMPLUD\r\n",  // 0x0D
+	"-asernotichfgwvx(-:/><z`!]*~#\\%}=@?+_&[|{$^9864527031';jq)\".k,bymplud\r\n",  // 0x0E
+	"-esnitahlgwvbLPAROFxGNUYMBj;:/<>z`Q&}J\\@$^*+{|=~_%#![Z?]9X864K5702V31'-Wq(DH)ECSIT\".k,ypmfudcor\r\n",  // 0x0F
+	"- \r\n",  // 0x10
+	"-QZXVWGDHCITNES ORAFLPYMUBKJ\r\n",  // 0x11
+	"-qzxvwgdhcitnes oraflpymubkj\r\n",  // 0x12
+	"-kwgmyphatr esnoicdfluvbLjCPqIMADREBVXZJKQNUGOHWTzYFSx\r\n",  // 0x13
+	"-123468 0795\r\n",  // 0x14
+	"-OSRE ITCAHLPMYWBXJZ4586930721QKVGUFDN\r\n",  // 0x15
+	"-osre itcahlpmywbxjz4586930721qkvgufdn\r\n",  // 0x16
+	"-Lbylpmdas ernotichufgwvkxqz120738654JZ9KQXVBWHMYDUNGEROATIFSPCj\r\n",  // 0x17
+	"-., )('/`<[!#%&_?}~=|{+*^$@]\\>:;-\"\r\n",  // 0x18
+	"-)(QZ>`%~?_}+=$@|&[{]\\!*^#:;/<'-JXVBWYMPLHARET SIONCDUFG,K.\"\r\n",  // 0x19
+	"-)(qz>`%~?_}+=$@|&[{]\\!*^#:;/<'-jxvbwymplharet sioncdufg,k.\"\r\n",  // 0x1A
+	"-C(P)L\".k,wmyplhat serioncdfugvbxjq-'<>/z:;`]ZJ\\!@#$%^&*{}|+_~=?[XKQVBWHYMDURENGOAFTIS\r\n",  // 0x1B
+	"-1234680= -,./\\;:[]!@#$%^&*()_+<>?'\"`{}|~975\r\n",  // 0x1C
+	"-PMYB.)JQ(>127035986^&?{![]@~+$*=_\\#%|}4`:;/Z<'-X\"K,VWGDHNITSE ROCAFLU\r\n",  // 0x1D
+	"-pmyb.)jq(>127035986^&?{![]@~+$*=_\\#%|}4`:;/z<'-x\"k,vwgdhnitse rocaflu\r\n",  // 0x1E
+	"-)L.k,wgyfdht eronisacplumvb\"xjFq-'<z>/:;`4[]!^JZ&*_+?~$%{|@}#=\\5968QKX370V21BWHYMDUREONGATI(CSP\r\n",  // 0x1F
+};
+
+// key orders: cursor stays on the selected key -- ip address, hostname, hex, float
+static constexpr const char* const keysetOrderStaySpecial[ 4 ] = {
+	"-786192.0354\r\n",  // ipaddr
+	"-tla.nicoerdsm-upfvbkqxjz1052937648ywgh\r\n",  // hostname
+	"-C249810AB63DE75F\r\n",  // hex
+	"-1324.609785\r\n",  // float
+};
+
+// key orders: cursor returns to the first key, KEYSET_HOME -- indexed by the composable flag bits
+static constexpr const char* const keysetOrderHome[ 32 ] = {
+	"-\r\n",  // 0x00
+	"-EOTINSHDPMGBKQZJXVWYFULCAR\r\n",  // 0x01
+	"-eotinshdpmgbkqzjxvwyfulcar\r\n",  // 0x02
+	"-eotrnshupmgvkLERNSUGDFqBWzXZJKQVMjHYxCOAPITbwyfldcai\r\n",  // 0x03
+	"-1234680975\r\n",  // 0x04
+	"-EOTINSHLPMGVKQJ32469857Z01XBWYFUDCAR\r\n",  // 0x05
+	"-eotinshlpmgvkqj32469857z01xbwyfudcar\r\n",  // 0x06
+	"-eotinshlfpgvkTROPNGYUDqWj0z74Q69ZJ8X5K23VB1MHxFCSIEALbwymudcar\r\n",  // 0x07
+	"-,.\")'/:>\\]@$^*+{|=~}?_&%#![`<;-(\r\n",  // 0x08
+	"-EOTRNSHDPYGV,KX(Q-Z:>\\]@$^*+{|=~}?_&%#![`</;'J)\".BWMFULCAI\r\n",  // 0x09
+	"-eotrnshdpygv,kx(q-z:>\\]@$^*+{|=~}?_&%#![`</;'j)\".bwmfulcai\r\n",  // 0x0A
+	"-eotrnshupygv,kLASP\"CU)YHjMB-V/<Q`K\\]@$^*+{|=~}?_&%#![ZJX>:z;W'qF(DxGORNEIT.bwmfldcai\r\n",  // 0x0B
+	"-1234680.\\:]@$^*)+>'`}~=-|{\"?<_(&%#![;/,975\r\n",  // 0x0C
+	"-EOTINSHLPMGV,K)(1-;:3>24`8\\]@$^*+{|=~}?_&%#![9657Z<0'J/QX\".BWYFUDCAR\r\n",  // 0x0D
+	"-eotinshlpmgv,k)(1-;:3>24`8\\]@$^*+{|=~}?_&%#![9657z<0'j/qx\".bwyfudcar\r\n",  // 0x0E
+	"-eotinshlfpgvbkTROP\"C)YUDM1WB;:0<z74`X8J\\]@$^*+{|=~}?_&%#![Z96Q5K2>3V'j-/q(HxFGNSIEAL.,wymudcar\r\n",  // 0x0F
+	"- \r\n",  // 0x10
+	"- EOTRNCLPFYWVXQZJKBGMUDHSAI\r\n",  // 0x11
+	"- eotrnclpfywvxqzjkbgmudhsai\r\n",  // 0x12
+	"- eotrncdupywvITASCOUjDMHBVQJZXKzWqYFxGRNPELkbgmflhsai\r\n",  // 0x13
+	"-1234680 975\r\n",  // 0x14
+	"- EOTRNCLPFYWVXQZ2358964701JKBGMUDHSAI\r\n",  // 0x15
+	"- eotrnclpfywvxqz2358964701jkbgmudhsai\r\n",  // 0x16
+	"- eotrncdupywvITASCOUjDMH1z2VQ358JZ964XK70BWqYFxGRNPELkbgmflhsai\r\n",  // 0x17
+	"- ,.)(-/`>[!#%&_?}~=|{+*^$@]\\<:;'\"\r\n",  // 0x18
+	"- EOTRNCLPFYWV.\"X(/'>;`[!#%&_?}~=|{+*^$@]\\:Z<-QJ)K,BGMUDHSAI\r\n",  // 0x19
+	"- eotrnclpfywv.\"x(/'>;`[!#%&_?}~=|{+*^$@]\\:z<-qj)k,bgmudhsai\r\n",  // 0x1A
+	"- eotincdupywv.ITASR\")Uj(Yq/-'>;VQ`Z[!#%&_?}~=|{+*^$@]\\JXK:z<BWHMDFxGOCNPELk,bgmflhsar\r\n",  // 0x1B
+	"-1234680.\\:]@$^*)+>'`}~= -|{\"?<_(&%#![;/,975\r\n",  // 0x1C
+	"- EOTRNCLPFYWV.\"X(/-<02;3469[!#%&_?}~=|{+*^$@]\\85`:7>Z'1QJ)K,BGMUDHSAI\r\n",  // 0x1D
+	"- eotrnclpfywv.\"x(/-<02;3469[!#%&_?}~=|{+*^$@]\\85`:7>z'1qj)k,bgmudhsai\r\n",  // 0x1E
+	"- eotincdupywv.ITASR\")Uj(Yq/1B<02;VQ3469Z[!#%&_?}~=|{+*^$@]\\J85`XK:7>z'-WHMDFxGOCNPELk,bgmflhsar\r\n",  // 0x1F
+};
+
+// key orders: cursor returns to the first key, KEYSET_HOME -- ip address, hostname, hex, float
+static constexpr const char* const keysetOrderHomeSpecial[ 4 ] = {
+	"-12.06735498\r\n",  // ipaddr
+	"-eo.tarcwhmuyvk68910qzjx54327bfpg-dslin\r\n",  // hostname
+	"-A8BD2C413F90E756\r\n",  // hex
+	"-.1236780954\r\n",  // float
+};
+
+/*
+	Close the 'PocuterUtil' namespace
+*/
+};
+
+#endif // _POCUTERUTIL_KEYBOARDORDER_H_
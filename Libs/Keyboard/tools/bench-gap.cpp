@@ -0,0 +1,153 @@
+//
+// Copyright 2023 Kallistisoft
+// GNU GPL-3 https://www.gnu.org/licenses/gpl-3.0.txt
+/*
+* [PocuterUtils]/Libs/Keyboard/tools/bench-gap.cpp
+*
+* Host benchmark of PocuterUtil::KeyboardGap against inserting into a plain string with memmove
+*
+* Build and run on the host from the keyboard library folder:
+*	g++ -O2 -std=c++11 -I. tools/bench-gap.cpp -o bench-gap && ./bench-gap
+*
+* Every run replays the same operations on both buffers and on a std::string, and checks that
+* all three end with the same text and cursor. See README.md file for the results.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "KeyboardGap.h"
+
+using namespace PocuterUtil;
+
+// operation: move the cursor by an offset, insert a character, or delete before the cursor
+enum { OP_MOVE, OP_INSERT, OP_ERASE };
+struct Op {
+	int kind;
+	int arg;
+};
+
+// plain string with a cursor, every edit moves the text after the cursor
+struct Flat {
+	std::vector<char> buffer;
+	uint32_t capacity;
+	uint32_t length;
+	uint32_t point;
+	uint64_t moved;
+
+	Flat( const std::string &text, uint32_t capacity ) : buffer( capacity + 1 ), capacity( capacity ), length( text.size() ), point( text.size() ), moved( 0 ) {
+		memcpy( buffer.data(), text.data(), text.size() );
+	}
+	void moveTo( uint32_t position ) { point = position > length ? length : position; }
+	void move( int offset ) { long p = (long) point + offset; moveTo( p < 0 ? 0 : p ); }
+	void insert( char c ) {
+		if( length == capacity ) return;
+		memmove( &buffer[point + 1], &buffer[point], length - point );
+		moved += length - point;
+		buffer[point++] = c;
+		length++;
+	}
+	void erase() {
+		if( !point ) return;
+		memmove( &buffer[point - 1], &buffer[point], length - point );
+		moved += length - point;
+		point--;
+		length--;
+	}
+	std::string text() { return std::string( buffer.data(), length ); }
+};
+
+// reference: std::string with a cursor
+struct Reference {
+	std::string text;
+	size_t capacity;
+	size_t point;
+
+	void move( int offset ) { long p = (long) point + offset; point = p < 0 ? 0 : p > (long) text.size() ? text.size() : p; }
+	void insert( char c ) { if( text.size() < capacity ) text.insert( point++, 1, c ); }
+	void erase() { if( point ) text.erase( --point, 1 ); }
+};
+
+// random operations: 40% moves of up to maxMove characters, 40% inserts, 20% deletes
+static std::vector<Op> randomOps( int count, unsigned seed, int maxMove ) {
+	std::vector<Op> ops;
+	srand( seed );
+	for( int i=0; i < count; i++ ) {
+		int r = rand() % 100;
+		if( r < 40 ) ops.push_back( { OP_MOVE, (rand() % (2 * maxMove + 1)) - maxMove } );
+		else if( r < 80 ) ops.push_back( { OP_INSERT, 'a' + rand() % 26 } );
+		else ops.push_back( { OP_ERASE, 0 } );
+	}
+	return ops;
+}
+
+static double nanos( std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, size_t count ) {
+	return std::chrono::duration<double, std::nano>( end - start ).count() / count;
+}
+
+// run: replay the operations from the middle of the text, print time and bytes moved per operation
+static bool run( const char *name, const std::string &init, const std::vector<Op> &ops ) {
+	uint32_t capacity = init.size() * 2;
+	std::vector<char> buffer( capacity + 1 );
+
+	KeyboardGap gap;
+	gap.init( buffer.data(), capacity );
+	gap.set( init.c_str() );
+	gap.moveTo( init.size() / 2 );
+	auto t0 = std::chrono::steady_clock::now();
+	for( const Op &op : ops ) {
+		if( op.kind == OP_MOVE ) gap.move( op.arg );
+		else if( op.kind == OP_INSERT ) gap.insert( op.arg );
+		else gap.erase();
+	}
+	uint32_t cursor = gap.cursor();
+	gap.text();
+	auto t1 = std::chrono::steady_clock::now();
+
+	Flat flat( init, capacity );
+	flat.moveTo( init.size() / 2 );
+	auto t2 = std::chrono::steady_clock::now();
+	for( const Op &op : ops ) {
+		if( op.kind == OP_MOVE ) flat.move( op.arg );
+		else if( op.kind == OP_INSERT ) flat.insert( op.arg );
+		else flat.erase();
+	}
+	auto t3 = std::chrono::steady_clock::now();
+
+	Reference ref = { init, capacity, init.size() / 2 };
+	for( const Op &op : ops ) {
+		if( op.kind == OP_MOVE ) ref.move( op.arg );
+		else if( op.kind == OP_INSERT ) ref.insert( op.arg );
+		else ref.erase();
+	}
+
+	bool ok = ref.text == gap.text() && ref.text == flat.text() && cursor == ref.point && flat.point == ref.point;
+	printf( "%6u bytes  %-16s  gap %6.1f ns/op %8.1f bytes/op  |  memmove %6.1f ns/op %8.1f bytes/op  %s\n",
+		(uint32_t) init.size(), name, nanos( t0, t1, ops.size() ), (double) gap.moves / ops.size(),
+		nanos( t2, t3, ops.size() ), (double) flat.moved / ops.size(), ok ? "ok" : "MISMATCH" );
+	return ok;
+}
+
+int main( int argc, char **argv ) {
+	int count = argc > 1 ? atoi( argv[1] ) : 200000;
+	bool ok = true;
+
+	for( int size : { 1024, 4096, 16384 } ) {
+		std::string init( size, 'x' );
+		for( int i=0; i < size; i++ ) init[i] = 'a' + i % 26;
+
+		// random: cursor keys one character at a time, short jumps, and jumps anywhere in the text
+		ok = run( "random, move 1", init, randomOps( count, 7, 1 ) ) && ok;
+		ok = run( "random, move 16", init, randomOps( count, 7, 16 ) ) && ok;
+		ok = run( "random, move any", init, randomOps( count, 7, size ) ) && ok;
+
+		// typing: a text of the same size typed into the middle
+		std::vector<Op> typing;
+		for( int i=0; i < size; i++ ) typing.push_back( { OP_INSERT, 'a' + i % 26 } );
+		ok = run( "type middle", init, typing ) && ok;
+	}
+	return ok ? 0 : 1;
+}